@@ -0,0 +1,691 @@
+#include "SDL.h"
+#undef main
+
+#include "imgui.h"
+#include "imgui_sdl.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <tuple>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+// Renders a few repeatable scenarios with the software renderer of SDL, without a window or a GPU, and prints how long ImGuiSDL::Render took
+// for each of them as one JSON object per line. Every scenario is run several times from a fresh ImGui context and renderer: the first frame of
+// every run is a cold frame with empty caches, the frames after it are warm frames.
+//
+// Usage: benchmark [--frames N] [--runs N] [--width N] [--height N] [--scenario NAME] [--no-render-geometry] [--no-cpu-rasterizer]
+//                  [--rasterize-frames] [--redraw-damaged-regions] [--cache-draw-lists] [--normalize-triangle-keys] [--render-scale S]
+//                  [--cache-fill-time MS] [--reorder-draws] [--simplify-style] [--compare-paths]
+//        benchmark --cache-benchmark
+//        benchmark --kernel-check [--triangles N] [--seed N]
+//
+// With --compare-paths, every scenario is rendered through SDL_RenderGeometry and through the software rasterizer side by side, into two
+// renderers from the same draw data. It prints how long each path took, how many pixels came out different per frame and the largest difference
+// of a color channel. The other flags apply to both paths. With SDL older than 2.0.18, both of them end up using the software rasterizer.
+//
+// The second form doesn't render anything. It times lookups, misses and evictions of the triangle cache's hash table with 1k, 10k and 100k keys,
+// next to the std::list and std::unordered_map based cache it replaced, and prints one JSON object per container and size.
+//
+// The third form doesn't render anything either. It rasterizes the same pseudo random triangles with every raster kernel the CPU supports and
+// with the scalar one, compares them pixel for pixel, and prints one JSON object per kernel with the number of pixels that differ. It exits with
+// an error if any do, so it can run as a test after changing the kernels or the compiler flags.
+//
+// The cache isn't part of the header, so this file isn't compiled on its own. Build imgui_sdl.cpp with IMGUI_SDL_BENCHMARK defined instead,
+// which includes this file at its end.
+
+namespace
+{
+	struct Settings
+	{
+		int Frames = 200;
+		int Runs = 5;
+		int Width = 1280;
+		int Height = 720;
+		std::string Scenario;
+		ImGuiSDL::Options Options;
+		bool CacheBenchmark = false;
+		bool KernelCheck = false;
+		bool ComparePaths = false;
+		int KernelTriangles = 10000;
+		Uint32 KernelSeed = 1;
+	};
+
+	struct Scenario
+	{
+		const char* Name;
+		// Builds the UI of a frame. The frame index starts at zero for every run, so every run draws exactly the same.
+		void (*Build)(int frame, int width, int height);
+	};
+
+	void BuildDemoWindow(int, int, int)
+	{
+		ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(550, 680), ImGuiCond_Always);
+		ImGui::ShowDemoWindow();
+	}
+
+	void BuildTable(int, int width, int height)
+	{
+		ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(static_cast<float>(width), static_cast<float>(height)), ImGuiCond_Always);
+		ImGui::Begin("Table", nullptr, ImGuiWindowFlags_NoDecoration);
+
+		if (ImGui::BeginTable("Rows", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+		{
+			for (int row = 0; row < 1000; row++)
+			{
+				ImGui::TableNextRow();
+				for (int column = 0; column < 6; column++)
+				{
+					ImGui::TableNextColumn();
+					ImGui::Text("Row %d, column %d", row, column);
+				}
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
+	void BuildTextWall(int, int width, int height)
+	{
+		ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(static_cast<float>(width), static_cast<float>(height)), ImGuiCond_Always);
+		ImGui::Begin("Text", nullptr, ImGuiWindowFlags_NoDecoration);
+
+		for (int line = 0; line < 60; line++)
+		{
+			ImGui::Text("%03d Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.", line);
+		}
+
+		ImGui::End();
+	}
+
+	void BuildPlots(int frame, int width, int height)
+	{
+		ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(static_cast<float>(width), static_cast<float>(height)), ImGuiCond_Always);
+		ImGui::Begin("Plots", nullptr, ImGuiWindowFlags_NoDecoration);
+
+		float values[200];
+		for (int plot = 0; plot < 8; plot++)
+		{
+			for (int i = 0; i < 200; i++)
+			{
+				values[i] = std::sin((frame + i) * 0.1f + plot) * std::cos(i * 0.03f * (plot + 1));
+			}
+
+			char label[32];
+			std::snprintf(label, sizeof(label), "Plot %d", plot);
+			ImGui::PlotLines(label, values, 200, 0, nullptr, -1.0f, 1.0f, ImVec2(static_cast<float>(width) - 100.0f, 70.0f));
+		}
+
+		ImGui::End();
+	}
+
+	void BuildResizingWindows(int frame, int width, int height)
+	{
+		// The windows grow and shrink by a few pixels every frame, the same as when the user drags a window border.
+		const float t = 0.5f + 0.5f * std::sin(frame * 0.05f);
+		ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+		ImGui::SetNextWindowSize(ImVec2(300.0f + t * (width - 320), 200.0f + t * (height - 220)), ImGuiCond_Always);
+		ImGui::ShowDemoWindow();
+	}
+
+	const Scenario Scenarios[] = {
+		{ "demo_window", BuildDemoWindow },
+		{ "large_table", BuildTable },
+		{ "text_wall", BuildTextWall },
+		{ "plots", BuildPlots },
+		{ "window_resize", BuildResizingWindows },
+	};
+
+	// Returns the value below which the given fraction of the sorted samples lie.
+	double Percentile(const std::vector<double>& sorted, double fraction)
+	{
+		if (sorted.empty()) return 0.0;
+		const size_t index = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+		return sorted[std::min(std::max(index, size_t(1)), sorted.size()) - 1];
+	}
+
+	void PrintTimes(const char* name, std::vector<double> times)
+	{
+		std::sort(times.begin(), times.end());
+		std::printf("\"%s\":{\"p50\":%.4f,\"p99\":%.4f,\"max\":%.4f}", name,
+			Percentile(times, 0.5), Percentile(times, 0.99), times.empty() ? 0.0 : times.back());
+	}
+
+	double Milliseconds(Uint64 start, Uint64 end)
+	{
+		return static_cast<double>(end - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	}
+
+	bool RunScenario(const Scenario& scenario, const Settings& settings)
+	{
+		std::vector<double> coldTimes, warmTimes;
+		size_t hits = 0, misses = 0, peakBytes = 0;
+
+		for (int run = 0; run < settings.Runs; run++)
+		{
+			SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, settings.Width, settings.Height, 32, SDL_PIXELFORMAT_ARGB8888);
+			SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+			if (!renderer)
+			{
+				std::fprintf(stderr, "Couldn't create the software renderer: %s\n", SDL_GetError());
+				if (surface) SDL_FreeSurface(surface);
+				return false;
+			}
+
+			ImGui::CreateContext();
+			ImGuiIO& io = ImGui::GetIO();
+			io.IniFilename = nullptr;
+			io.DeltaTime = 1.0f / 60.0f;
+			io.MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
+
+			ImGuiSDL::Initialize(renderer, settings.Width, settings.Height, settings.Options);
+
+			// ImGui needs a couple of frames to lay out new windows, those aren't rendered so that the first rendered frame is still cold.
+			for (int frame = -3; frame < settings.Frames; frame++)
+			{
+				ImGui::NewFrame();
+				scenario.Build(std::max(frame, 0), settings.Width, settings.Height);
+				ImGui::Render();
+				if (frame < 0) continue;
+
+				SDL_SetRenderDrawColor(renderer, 114, 144, 154, 255);
+				SDL_RenderClear(renderer);
+
+				const Uint64 start = SDL_GetPerformanceCounter();
+				ImGuiSDL::Render(ImGui::GetDrawData());
+				const double time = Milliseconds(start, SDL_GetPerformanceCounter());
+
+				const ImGuiSDL::Stats& stats = ImGuiSDL::GetStats();
+				peakBytes = std::max(peakBytes, stats.CachedTextureBytes);
+				if (frame == 0)
+				{
+					coldTimes.push_back(time);
+					continue;
+				}
+
+				warmTimes.push_back(time);
+				hits += stats.TriangleCacheHits;
+				misses += stats.TriangleCacheMisses;
+			}
+
+			ImGuiSDL::Deinitialize();
+			ImGui::DestroyContext();
+			SDL_DestroyRenderer(renderer);
+			SDL_FreeSurface(surface);
+		}
+
+		std::printf("{\"scenario\":\"%s\",\"width\":%d,\"height\":%d,\"runs\":%d,\"frames\":%d,", scenario.Name, settings.Width, settings.Height, settings.Runs, settings.Frames);
+		PrintTimes("cold_ms", coldTimes);
+		std::printf(",");
+		PrintTimes("warm_ms", warmTimes);
+		std::printf(",\"cache_hit_rate\":%.4f,\"peak_texture_bytes\":%lu}\n",
+			hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 1.0, static_cast<unsigned long>(peakBytes));
+		std::fflush(stdout);
+		return true;
+	}
+
+	// Renders with one renderer into a surface of its own, and reads back what it drew.
+	struct Target
+	{
+		SDL_Surface* Surface = nullptr;
+		SDL_Renderer* Renderer = nullptr;
+		std::vector<Uint32> Pixels;
+
+		bool Create(int width, int height)
+		{
+			Surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+			Renderer = Surface ? SDL_CreateSoftwareRenderer(Surface) : nullptr;
+			if (!Renderer) std::fprintf(stderr, "Couldn't create the software renderer: %s\n", SDL_GetError());
+			Pixels.resize(static_cast<size_t>(width) * height);
+			return Renderer != nullptr;
+		}
+
+		void Destroy()
+		{
+			if (Renderer) SDL_DestroyRenderer(Renderer);
+			if (Surface) SDL_FreeSurface(Surface);
+		}
+
+		void Clear()
+		{
+			SDL_SetRenderDrawColor(Renderer, 114, 144, 154, 255);
+			SDL_RenderClear(Renderer);
+		}
+
+		// SDL batches draw calls, flushing them makes the time that the renderer takes part of the time of the path that issued them.
+		void Flush()
+		{
+			SDL_RenderFlush(Renderer);
+		}
+
+		void ReadPixels()
+		{
+			SDL_RenderReadPixels(Renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, Pixels.data(), Surface->w * static_cast<int>(sizeof(Uint32)));
+		}
+	};
+
+	bool ComparePaths(const Scenario& scenario, const Settings& settings)
+	{
+		Target geometry, software;
+		if (!geometry.Create(settings.Width, settings.Height) || !software.Create(settings.Width, settings.Height))
+		{
+			geometry.Destroy();
+			software.Destroy();
+			return false;
+		}
+
+		ImGui::CreateContext();
+		ImGuiIO& io = ImGui::GetIO();
+		io.IniFilename = nullptr;
+		io.DeltaTime = 1.0f / 60.0f;
+		io.MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
+
+		// Initialize sets up the display size and the style, the second context only has to render the same draw data.
+		ImGuiSDL::Options options = settings.Options;
+		options.UseRenderGeometry = true;
+		ImGuiSDL::Initialize(geometry.Renderer, settings.Width, settings.Height, options);
+		options.UseRenderGeometry = false;
+		ImGuiSDL::Context* softwareContext = ImGuiSDL::CreateContext(software.Renderer);
+		ImGuiSDL::SetOptions(softwareContext, options);
+
+		std::vector<double> geometryTimes, softwareTimes, differences;
+		double geometryCold = 0.0, softwareCold = 0.0;
+		int maxDifference = 0;
+		for (int frame = -3; frame < settings.Frames; frame++)
+		{
+			ImGui::NewFrame();
+			scenario.Build(std::max(frame, 0), settings.Width, settings.Height);
+			ImGui::Render();
+			if (frame < 0) continue;
+
+			geometry.Clear();
+			Uint64 start = SDL_GetPerformanceCounter();
+			ImGuiSDL::Render(ImGui::GetDrawData());
+			geometry.Flush();
+			const double geometryTime = Milliseconds(start, SDL_GetPerformanceCounter());
+			geometry.ReadPixels();
+
+			software.Clear();
+			start = SDL_GetPerformanceCounter();
+			ImGuiSDL::Render(softwareContext, ImGui::GetDrawData());
+			software.Flush();
+			const double softwareTime = Milliseconds(start, SDL_GetPerformanceCounter());
+			software.ReadPixels();
+
+			size_t differing = 0;
+			for (size_t i = 0; i < geometry.Pixels.size(); i++)
+			{
+				const Uint32 a = geometry.Pixels[i], b = software.Pixels[i];
+				if (a == b) continue;
+				differing++;
+				for (int shift = 0; shift < 32; shift += 8)
+				{
+					maxDifference = std::max(maxDifference, std::abs(static_cast<int>((a >> shift) & 0xff) - static_cast<int>((b >> shift) & 0xff)));
+				}
+			}
+			differences.push_back(static_cast<double>(differing));
+
+			if (frame == 0)
+			{
+				geometryCold = geometryTime;
+				softwareCold = softwareTime;
+				continue;
+			}
+			geometryTimes.push_back(geometryTime);
+			softwareTimes.push_back(softwareTime);
+		}
+
+		ImGuiSDL::DestroyContext(softwareContext);
+		ImGuiSDL::Deinitialize();
+		ImGui::DestroyContext();
+		geometry.Destroy();
+		software.Destroy();
+
+		std::printf("{\"scenario\":\"%s\",\"compare_paths\":true,\"width\":%d,\"height\":%d,\"frames\":%d,\"geometry_cold_ms\":%.4f,\"software_cold_ms\":%.4f,",
+			scenario.Name, settings.Width, settings.Height, settings.Frames, geometryCold, softwareCold);
+		PrintTimes("geometry_warm_ms", geometryTimes);
+		std::printf(",");
+		PrintTimes("software_warm_ms", softwareTimes);
+		std::printf(",");
+		PrintTimes("differing_pixels", differences);
+		std::printf(",\"max_differing_fraction\":%.6f,\"max_channel_difference\":%d}\n",
+			*std::max_element(differences.begin(), differences.end()) / (static_cast<double>(settings.Width) * settings.Height), maxDifference);
+		std::fflush(stdout);
+		return true;
+	}
+
+	// The key of the triangle cache, and the tuple key and hash combiner that the cache used before it was a flat hash table.
+	using TriangleKey = ImGuiSDL::Internal::Device::TriangleKey;
+	using TriangleVertexKey = ImGuiSDL::Internal::Device::TriangleVertexKey;
+
+	using TupleVertexKey = std::tuple<float, float, float, float, uint32_t>;
+	using TupleKey = std::tuple<TupleVertexKey, TupleVertexKey, TupleVertexKey, SDL_Texture*>;
+
+	namespace TupleHash
+	{
+		template <typename T> struct Hash
+		{
+			std::size_t operator()(const T& value) const
+			{
+				return std::hash<T>()(value);
+			}
+		};
+
+		template <typename T> void CombineHash(std::size_t& seed, const T& value)
+		{
+			seed ^= TupleHash::Hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+
+		template <typename Tuple, std::size_t Index = std::tuple_size<Tuple>::value - 1> struct Hasher
+		{
+			static void Hash(std::size_t& seed, const Tuple& tuple)
+			{
+				Hasher<Tuple, Index - 1>::Hash(seed, tuple);
+				CombineHash(seed, std::get<Index>(tuple));
+			}
+		};
+
+		template <typename Tuple> struct Hasher<Tuple, 0>
+		{
+			static void Hash(std::size_t& seed, const Tuple& tuple)
+			{
+				CombineHash(seed, std::get<0>(tuple));
+			}
+		};
+
+		template <typename... T> struct Hash<std::tuple<T...>>
+		{
+			std::size_t operator()(const std::tuple<T...>& value) const
+			{
+				std::size_t seed = 0;
+				Hasher<std::tuple<T...>>::Hash(seed, value);
+				return seed;
+			}
+		};
+	}
+
+	// The previous cache, with the same interface as it had: Contains followed by At for a hit, and Clean to evict down to the capacity.
+	template <typename Key, typename Value> class ListCache
+	{
+	public:
+		void SetCapacity(size_t capacity) { Capacity = capacity; }
+
+		bool Contains(const Key& key) const
+		{
+			return Container.find(key) != Container.end();
+		}
+
+		const Value& At(const Key& key)
+		{
+			const auto location = Container.find(key);
+			Order.splice(Order.begin(), Order, location->second);
+			return location->second->second;
+		}
+
+		void Insert(const Key& key, Value value)
+		{
+			const auto existingLocation = Container.find(key);
+			if (existingLocation != Container.end())
+			{
+				Order.erase(existingLocation->second);
+				Container.erase(existingLocation);
+			}
+
+			Order.push_front(std::make_pair(key, std::move(value)));
+			Container.insert(std::make_pair(key, Order.begin()));
+		}
+
+		void Clean()
+		{
+			while (Container.size() > Capacity)
+			{
+				auto last = Order.end();
+				last--;
+				Container.erase(last->first);
+				Order.pop_back();
+			}
+		}
+
+	private:
+		size_t Capacity = 0;
+		std::list<std::pair<Key, Value>> Order;
+		std::unordered_map<Key, decltype(Order.begin()), TupleHash::Hash<Key>> Container;
+	};
+
+	// Random triangles of up to 64 pixels in size, about what the cache holds for a UI.
+	std::vector<TriangleKey> MakeTriangleKeys(size_t count)
+	{
+		Uint32 seed = 12345;
+		const auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+		std::vector<TriangleKey> keys(count);
+		for (TriangleKey& key : keys)
+		{
+			std::memset(&key, 0, sizeof(key));
+			for (TriangleVertexKey& vertex : key.Vertices)
+			{
+				vertex = { (next() % 1024) / 16.0f, (next() % 1024) / 16.0f, (next() % 512) / 512.0f, (next() % 512) / 512.0f, next() ^ (next() << 8) };
+			}
+		}
+		return keys;
+	}
+
+	TupleKey MakeTupleKey(const TriangleKey& key)
+	{
+		const TriangleVertexKey* v = key.Vertices;
+		return std::make_tuple(
+			std::make_tuple(v[0].X, v[0].Y, v[0].U, v[0].V, v[0].Color),
+			std::make_tuple(v[1].X, v[1].Y, v[1].U, v[1].V, v[1].Color),
+			std::make_tuple(v[2].X, v[2].Y, v[2].U, v[2].V, v[2].Color),
+			key.Texture);
+	}
+
+	struct CacheTimes
+	{
+		double Hit = 0.0, Miss = 0.0, Evict = 0.0;
+	};
+
+	// Every pass looks up all cached keys, then as many keys that aren't cached, and then inserts those, which evicts all of the cached ones.
+	const int CachePasses = 10;
+
+	template <typename Cache, typename HitFunction, typename MissFunction, typename EvictFunction>
+	CacheTimes TimeCache(Cache& cache, const std::vector<TriangleKey>& keys, HitFunction&& hit, MissFunction&& miss, EvictFunction&& evict)
+	{
+		const size_t count = keys.size() / 2;
+		for (size_t i = 0; i < count; i++) evict(cache, keys[i], static_cast<Uint32>(i));
+
+		CacheTimes times;
+		size_t found = 0;
+		for (int pass = 0; pass < CachePasses; pass++)
+		{
+			const size_t cached = (pass % 2) * count, other = count - cached;
+
+			Uint64 start = SDL_GetPerformanceCounter();
+			for (size_t i = 0; i < count; i++) found += hit(cache, keys[cached + i]);
+			times.Hit += Milliseconds(start, SDL_GetPerformanceCounter());
+
+			start = SDL_GetPerformanceCounter();
+			for (size_t i = 0; i < count; i++) found += miss(cache, keys[other + i]);
+			times.Miss += Milliseconds(start, SDL_GetPerformanceCounter());
+
+			start = SDL_GetPerformanceCounter();
+			for (size_t i = 0; i < count; i++) evict(cache, keys[other + i], static_cast<Uint32>(i));
+			times.Evict += Milliseconds(start, SDL_GetPerformanceCounter());
+		}
+
+		if (found != CachePasses * count) std::fprintf(stderr, "The cache found %lu keys instead of %lu\n", static_cast<unsigned long>(found),
+			static_cast<unsigned long>(CachePasses * count));
+
+		// Nanoseconds per operation.
+		const double operations = static_cast<double>(CachePasses) * count / 1e6;
+		times.Hit /= operations;
+		times.Miss /= operations;
+		times.Evict /= operations;
+		return times;
+	}
+
+	void PrintCacheTimes(const char* container, size_t count, const CacheTimes& times)
+	{
+		std::printf("{\"cache\":\"%s\",\"keys\":%lu,\"passes\":%d,\"hit_ns\":%.1f,\"miss_ns\":%.1f,\"evict_ns\":%.1f}\n", container,
+			static_cast<unsigned long>(count), CachePasses, times.Hit, times.Miss, times.Evict);
+		std::fflush(stdout);
+	}
+
+	void RunCacheBenchmark()
+	{
+		for (size_t count : { size_t(1000), size_t(10000), size_t(100000) })
+		{
+			const std::vector<TriangleKey> keys = MakeTriangleKeys(count * 2);
+
+			{
+				ImGuiSDL::Internal::LRUCache<TriangleKey, Uint32> cache;
+				PrintCacheTimes("flat", count, TimeCache(cache, keys,
+					[](decltype(cache)& c, const TriangleKey& key) { return c.TryGet(key) ? 1 : 0; },
+					[](decltype(cache)& c, const TriangleKey& key) { return c.TryGet(key) ? 1 : 0; },
+					[count](decltype(cache)& c, const TriangleKey& key, Uint32 value)
+					{
+						if (c.GetSize() >= count) c.EvictLeastRecent();
+						c.Insert(key, value);
+					}));
+			}
+
+			{
+				std::vector<TupleKey> tupleKeys;
+				for (const TriangleKey& key : keys) tupleKeys.push_back(MakeTupleKey(key));
+
+				// The tuple keys are looked up through the index of the triangle key, so that both containers see the same keys in the same order.
+				const TriangleKey* first = keys.data();
+				ListCache<TupleKey, Uint32> cache;
+				cache.SetCapacity(count);
+				PrintCacheTimes("list", count, TimeCache(cache, keys,
+					[&](decltype(cache)& c, const TriangleKey& key)
+					{
+						const TupleKey& tupleKey = tupleKeys[&key - first];
+						return c.Contains(tupleKey) ? (c.At(tupleKey), 1) : 0;
+					},
+					[&](decltype(cache)& c, const TriangleKey& key) { return c.Contains(tupleKeys[&key - first]) ? 1 : 0; },
+					[&](decltype(cache)& c, const TriangleKey& key, Uint32 value)
+					{
+						c.Insert(tupleKeys[&key - first], value);
+						c.Clean();
+					}));
+			}
+		}
+	}
+
+	// Small triangles are what the UI mostly draws, the large ones have spans long enough to use every lane of the vector kernels many times over.
+	bool RunKernelCheck(const Settings& settings)
+	{
+		bool matches = true;
+		for (const ImGuiSDL::Internal::RasterKernel& kernel : ImGuiSDL::Internal::GetSupportedRasterKernels())
+		{
+			for (int size : { 32, 256 })
+			{
+				const Uint64 start = SDL_GetPerformanceCounter();
+				const ImGuiSDL::Internal::KernelComparison comparison = ImGuiSDL::Internal::CompareWithScalarKernel(kernel, settings.KernelSeed,
+					settings.KernelTriangles, size);
+				const double time = Milliseconds(start, SDL_GetPerformanceCounter());
+
+				std::printf("{\"kernel\":\"%s\",\"seed\":%lu,\"size\":%d,\"triangles\":%d,\"pixels\":%lu,\"mismatched_pixels\":%lu,\"ms\":%.1f}\n", kernel.Name,
+					static_cast<unsigned long>(settings.KernelSeed), size, comparison.Triangles, static_cast<unsigned long>(comparison.Pixels),
+					static_cast<unsigned long>(comparison.Mismatches), time);
+				std::fflush(stdout);
+				matches = matches && comparison.Mismatches == 0;
+			}
+		}
+		return matches;
+	}
+
+	bool ParseArguments(int argc, char** argv, Settings& settings)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* argument = argv[i];
+			const bool hasValue = i + 1 < argc;
+
+			if (std::strcmp(argument, "--frames") == 0 && hasValue) settings.Frames = std::max(std::atoi(argv[++i]), 1);
+			else if (std::strcmp(argument, "--runs") == 0 && hasValue) settings.Runs = std::max(std::atoi(argv[++i]), 1);
+			else if (std::strcmp(argument, "--width") == 0 && hasValue) settings.Width = std::max(std::atoi(argv[++i]), 320);
+			else if (std::strcmp(argument, "--height") == 0 && hasValue) settings.Height = std::max(std::atoi(argv[++i]), 240);
+			else if (std::strcmp(argument, "--scenario") == 0 && hasValue) settings.Scenario = argv[++i];
+			else if (std::strcmp(argument, "--no-render-geometry") == 0) settings.Options.UseRenderGeometry = false;
+			else if (std::strcmp(argument, "--no-cpu-rasterizer") == 0) settings.Options.RasterizeOnCPU = false;
+			else if (std::strcmp(argument, "--rasterize-frames") == 0) settings.Options.RasterizeFrames = true;
+			else if (std::strcmp(argument, "--redraw-damaged-regions") == 0) settings.Options.RedrawDamagedRegions = true;
+			else if (std::strcmp(argument, "--cache-draw-lists") == 0) settings.Options.CacheDrawLists = true;
+			else if (std::strcmp(argument, "--normalize-triangle-keys") == 0) settings.Options.NormalizeTriangleKeys = true;
+			else if (std::strcmp(argument, "--cache-benchmark") == 0) settings.CacheBenchmark = true;
+			else if (std::strcmp(argument, "--kernel-check") == 0) settings.KernelCheck = true;
+			else if (std::strcmp(argument, "--compare-paths") == 0) settings.ComparePaths = true;
+			else if (std::strcmp(argument, "--triangles") == 0 && hasValue) settings.KernelTriangles = std::max(std::atoi(argv[++i]), 1);
+			else if (std::strcmp(argument, "--seed") == 0 && hasValue) settings.KernelSeed = static_cast<Uint32>(std::strtoul(argv[++i], nullptr, 10));
+			else if (std::strcmp(argument, "--reorder-draws") == 0) settings.Options.ReorderDraws = true;
+			else if (std::strcmp(argument, "--simplify-style") == 0) settings.Options.SimplifyStyle = true;
+			else if (std::strcmp(argument, "--cache-fill-time") == 0 && hasValue) settings.Options.TriangleCacheFillTime = std::max(std::atof(argv[++i]), 0.0);
+			else if (std::strcmp(argument, "--render-scale") == 0 && hasValue) settings.Options.RenderScale = std::max(static_cast<float>(std::atof(argv[++i])), 0.1f);
+			else
+			{
+				std::fprintf(stderr, "Unknown argument: %s\n", argument);
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Settings settings;
+	if (!ParseArguments(argc, argv, settings)) return 1;
+
+	if (settings.CacheBenchmark)
+	{
+		RunCacheBenchmark();
+		return 0;
+	}
+
+	if (settings.KernelCheck)
+	{
+		return RunKernelCheck(settings) ? 0 : 1;
+	}
+
+	// The dummy video driver doesn't need a display, the software renderer draws into a plain surface.
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+	if (SDL_Init(SDL_INIT_VIDEO) != 0)
+	{
+		std::fprintf(stderr, "Couldn't initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	bool ranAny = false;
+	for (const Scenario& scenario : Scenarios)
+	{
+		if (!settings.Scenario.empty() && settings.Scenario != scenario.Name) continue;
+		if (!(settings.ComparePaths ? ComparePaths(scenario, settings) : RunScenario(scenario, settings)))
+		{
+			SDL_Quit();
+			return 1;
+		}
+		ranAny = true;
+	}
+
+	SDL_Quit();
+
+	if (!ranAny)
+	{
+		std::fprintf(stderr, "Unknown scenario: %s\n", settings.Scenario.c_str());
+		return 1;
+	}
+	return 0;
+}
@@ -66,6 +66,8 @@ int main()
 		ImGui::Image(texture, ImVec2(100, 100));
 		ImGui::End();
 
+		ImGuiSDL::ShowStatsWindow();
+
 		SDL_SetRenderDrawColor(renderer, 114, 144, 154, 255);
 		SDL_RenderClear(renderer);
 
@@ -5,671 +5,4980 @@
 #include "imgui.h"
 
 #include <map>
-#include <list>
 #include <cmath>
+#include <cfloat>
+#include <climits>
 #include <array>
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include <vector>
 #include <memory>
+#include <cstring>
+#include <cstdint>
 #include <iostream>
 #include <algorithm>
 #include <functional>
-#include <unordered_map>
+#include <condition_variable>
 
-namespace
+// Capture files are memory mapped where the platform supports it, and read into memory otherwise.
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define IMGUI_SDL_HAS_MMAP 1
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define IMGUI_SDL_HAS_RENDER_GEOMETRY 1
+#else
+#define IMGUI_SDL_HAS_RENDER_GEOMETRY 0
+#endif
+
+// Vectorized rasterizer kernels. SSE2 is always available on x64, AVX2 code is compiled separately and only used if the CPU supports it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMGUI_SDL_HAS_SSE2 1
+#else
+#define IMGUI_SDL_HAS_SSE2 0
+#endif
+
+#if IMGUI_SDL_HAS_SSE2 && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#include <immintrin.h>
+#define IMGUI_SDL_HAS_AVX2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define IMGUI_SDL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#include <intrin.h>
+#define IMGUI_SDL_TARGET_AVX2
+#endif
+#else
+#define IMGUI_SDL_HAS_AVX2 0
+#endif
+
+// Hides a floating point value in a vector register from the optimizer, so that the multiplication that produced it can't be fused with an addition.
+// MSVC only fuses them with /fp:contract or /fp:fast, and never in intrinsics.
+#if IMGUI_SDL_HAS_SSE2 && (defined(__GNUC__) || defined(__clang__))
+#define IMGUI_SDL_UNFUSED(value) __asm__("" : "+x"(value))
+#else
+#define IMGUI_SDL_UNFUSED(value) (void)(value)
+#endif
+
+// The internals of the renderer. They have a namespace of their own instead of an anonymous one, since the public Context is built on them.
+namespace ImGuiSDL
+{
+	namespace Internal
+	{
+		// Hashes a block of memory eight bytes at a time. This isn't meant to be a strong hash, it only has to tell draw data and cache keys apart.
+		Uint64 HashBytes(const void* data, size_t size, Uint64 seed)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			Uint64 hash = seed ^ (size * 0x9e3779b97f4a7c15ull);
+
+			for (; size >= sizeof(Uint64); bytes += sizeof(Uint64), size -= sizeof(Uint64))
+			{
+				Uint64 word;
+				std::memcpy(&word, bytes, sizeof(Uint64));
+				hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+				hash ^= hash >> 32;
+			}
+
+			Uint64 rest = 0;
+			std::memcpy(&rest, bytes, size);
+			hash = (hash ^ rest) * 0xc4ceb9fe1a85ec53ull;
+			return hash ^ (hash >> 29);
+		}
+
+		// Converts the clip rectangle of a draw command to whole pixels, rounding its edges outwards so that it covers every pixel it touches. Everything
+		// that clips, culls or tracks damage by a command goes through this, so that they all agree on which pixels the command can draw to.
+		SDL_Rect GetClipRect(const ImVec4& clip)
+		{
+			const int minX = static_cast<int>(SDL_floor(clip.x)), minY = static_cast<int>(SDL_floor(clip.y));
+			const int maxX = static_cast<int>(SDL_ceil(clip.z)), maxY = static_cast<int>(SDL_ceil(clip.w));
+			return SDL_Rect{ minX, minY, maxX - minX, maxY - minY };
+		}
+
+		// Adds the time between its construction and destruction to a counter, in milliseconds.
+		class ScopedTimer
+		{
+		public:
+			explicit ScopedTimer(double& total) : Total(total), Start(SDL_GetPerformanceCounter()) { }
+			~ScopedTimer() { Total += static_cast<double>(SDL_GetPerformanceCounter() - Start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()); }
+
+			ScopedTimer(const ScopedTimer&) = delete;
+			ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+		private:
+			double& Total;
+			Uint64 Start;
+		};
+
+		// A read only view of a whole file, which is memory mapped where the platform supports it.
+		class MappedFile
+		{
+		public:
+			MappedFile() = default;
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			~MappedFile()
+			{
+#if defined(_WIN32)
+				if (Data) UnmapViewOfFile(Data);
+				if (Mapping) CloseHandle(Mapping);
+				if (File != INVALID_HANDLE_VALUE) CloseHandle(File);
+#elif IMGUI_SDL_HAS_MMAP
+				if (Data) munmap(const_cast<unsigned char*>(Data), Size);
+#else
+				SDL_free(const_cast<unsigned char*>(Data));
+#endif
+			}
+
+			bool Open(const char* path)
+			{
+#if defined(_WIN32)
+				File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				LARGE_INTEGER size;
+				if (File == INVALID_HANDLE_VALUE || !GetFileSizeEx(File, &size) || size.QuadPart == 0) return false;
+
+				Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (!Mapping) return false;
+				Data = static_cast<const unsigned char*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+				Size = static_cast<size_t>(size.QuadPart);
+#elif IMGUI_SDL_HAS_MMAP
+				const int file = open(path, O_RDONLY);
+				if (file < 0) return false;
+
+				struct stat status;
+				if (fstat(file, &status) == 0 && status.st_size > 0)
+				{
+					void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+					if (data != MAP_FAILED)
+					{
+						Data = static_cast<const unsigned char*>(data);
+						Size = static_cast<size_t>(status.st_size);
+					}
+				}
+				close(file);
+#else
+				Data = static_cast<const unsigned char*>(SDL_LoadFile(path, &Size));
+#endif
+				return Data != nullptr;
+			}
+
+			const unsigned char* GetData() const { return Data; }
+			size_t GetSize() const { return Size; }
+
+		private:
+			const unsigned char* Data = nullptr;
+			size_t Size = 0;
+#if defined(_WIN32)
+			HANDLE File = INVALID_HANDLE_VALUE;
+			HANDLE Mapping = nullptr;
+#endif
+		};
+
+		// Capture files start with a header, followed by the pixels of the font texture and then by every draw list: its CaptureList, its commands, its
+		// vertices and its indices. Every part starts at a multiple of eight bytes, so that the vertices and indices can be used right where they are
+		// in the mapped file. Everything is stored in the byte order of the machine that wrote it.
+		struct CaptureHeader
+		{
+			char Magic[8];
+			Uint32 Version;
+			// The sizes of ImDrawVert and ImDrawIdx, captures can only be replayed with an ImGui that's configured the same way.
+			Uint32 VertexSize, IndexSize;
+			Uint32 ListCount;
+			float DisplayPos[2], DisplaySize[2], FramebufferScale[2];
+			Uint32 FontWidth, FontHeight;
+			float WhitePixel[2];
+		};
+
+		struct CaptureList
+		{
+			Uint32 VertexCount, IndexCount, CommandCount, Unused;
+		};
+
+		// Textures are stored as handles: zero for no texture, one for the font texture, and then the other textures in the order they're first used.
+		struct CaptureCommand
+		{
+			float ClipRect[4];
+			Uint32 Texture;
+			Uint32 ElemCount;
+		};
+
+		static_assert(sizeof(CaptureHeader) % 8 == 0 && sizeof(CaptureList) % 8 == 0 && sizeof(CaptureCommand) % 8 == 0, "Capture parts must keep the alignment");
+
+		constexpr char CaptureMagic[8] = { 'I', 'M', 'S', 'D', 'L', 'C', 'A', 'P' };
+		constexpr Uint32 CaptureVersion = 1;
+		constexpr Uint32 FontTextureHandle = 1;
+
+		// Draw commands refer to the font with the address of this variable as their texture ID, whichever context draws them. It belongs to the
+		// library rather than to a renderer, so it stays valid while contexts come and go, and every context swaps in its own font texture for it.
+		char FontTextureSentinel;
+
+		bool IsFontTexture(ImTextureID textureId)
+		{
+			return textureId == static_cast<ImTextureID>(&FontTextureSentinel);
+		}
+
+		// Hashes keys as their raw bytes, which is a lot faster than combining the hashes of their members. Only works for keys without padding bytes,
+		// since those aren't guaranteed to be the same for equal keys.
+		struct RawBytesHash
+		{
+			template <typename Key> Uint64 operator()(const Key& key) const
+			{
+				return HashBytes(&key, sizeof(Key), 0);
+			}
+		};
+
+		// Least recently used cache in a flat hash table with open addressing. The items are stored next to each other and linked in recency order by
+		// their indices, and the places of removed items are reused, so a warmed up cache doesn't allocate at all.
+		template <typename Key, typename Value, typename Hash = RawBytesHash> class LRUCache
+		{
+		public:
+			size_t GetSize() const { return Size; }
+
+			// Returns the value of the key and marks it as the most recently used one, or returns null if the key isn't cached. The pointer is only valid
+			// until the next change to the cache.
+			Value* TryGet(const Key& key)
+			{
+				if (Size == 0) return nullptr;
+
+				const Uint32 slot = FindSlot(key, static_cast<Uint32>(Hash()(key)));
+				const Uint32 index = Slots[slot].Index;
+				if (index == None) return nullptr;
+
+				Unlink(index);
+				LinkFront(index);
+				return &Items[index].ItemValue;
+			}
+
+			// Same as TryGet, without marking the key as the most recently used one.
+			Value* Peek(const Key& key)
+			{
+				if (Size == 0) return nullptr;
+
+				const Uint32 index = Slots[FindSlot(key, static_cast<Uint32>(Hash()(key)))].Index;
+				return index != None ? &Items[index].ItemValue : nullptr;
+			}
+
+			void Insert(const Key& key, Value value)
+			{
+				if ((Size + 1) * 2 > Slots.size()) Grow();
+
+				const Uint32 tag = static_cast<Uint32>(Hash()(key));
+				const Uint32 slot = FindSlot(key, tag);
+				Uint32 index = Slots[slot].Index;
+				if (index != None)
+				{
+					Items[index].ItemValue = std::move(value);
+					Unlink(index);
+				}
+				else
+				{
+					if (FreeItems != None)
+					{
+						index = FreeItems;
+						FreeItems = Items[index].Next;
+						Items[index].ItemKey = key;
+						Items[index].ItemValue = std::move(value);
+						Items[index].Tag = tag;
+					}
+					else
+					{
+						index = static_cast<Uint32>(Items.size());
+						Items.push_back(Item{ key, std::move(value), tag, None, None });
+					}
+
+					Slots[slot] = Slot{ index, tag };
+					Size++;
+				}
+
+				LinkFront(index);
+			}
+
+			void Reset()
+			{
+				Items.clear();
+				Slots.clear();
+				Size = 0;
+				Newest = Oldest = FreeItems = None;
+			}
+
+			// Removes the key and hands back its value, or returns an empty value if the key isn't cached.
+			Value Take(const Key& key)
+			{
+				if (Size == 0) return Value();
+
+				const Uint32 index = Slots[FindSlot(key, static_cast<Uint32>(Hash()(key)))].Index;
+				if (index == None) return Value();
+
+				Value value = std::move(Items[index].ItemValue);
+				Remove(index);
+				return value;
+			}
+
+			// Removes the least recently used item and hands it back, or returns an empty value if there are no items.
+			Value EvictLeastRecent()
+			{
+				if (Oldest == None) return Value();
+
+				Value value = std::move(Items[Oldest].ItemValue);
+				Remove(Oldest);
+				return value;
+			}
+
+		private:
+			static constexpr Uint32 None = ~Uint32(0);
+
+			struct Item
+			{
+				Key ItemKey;
+				Value ItemValue;
+				Uint32 Tag;
+				// Neighbours in recency order while the item is cached, or the next free item after it was removed.
+				Uint32 Previous, Next;
+			};
+
+			// The lower bits of the hash are kept with every slot, so that probing rarely has to look at the items themselves.
+			struct Slot
+			{
+				Uint32 Index;
+				Uint32 Tag;
+			};
+
+			// Returns the slot of the key, or the empty slot that ends its probe sequence if the key isn't cached.
+			Uint32 FindSlot(const Key& key, Uint32 tag) const
+			{
+				const Uint32 mask = static_cast<Uint32>(Slots.size()) - 1;
+				Uint32 slot = tag & mask;
+				while (Slots[slot].Index != None && (Slots[slot].Tag != tag || !(Items[Slots[slot].Index].ItemKey == key))) slot = (slot + 1) & mask;
+				return slot;
+			}
+
+			// Keeps the table at most half full, which keeps the probe sequences short.
+			void Grow()
+			{
+				Slots.assign(std::max<size_t>(16, Slots.size() * 2), Slot{ None, 0 });
+
+				const Uint32 mask = static_cast<Uint32>(Slots.size()) - 1;
+				for (Uint32 index = Newest; index != None; index = Items[index].Next)
+				{
+					Uint32 slot = Items[index].Tag & mask;
+					while (Slots[slot].Index != None) slot = (slot + 1) & mask;
+					Slots[slot] = Slot{ index, Items[index].Tag };
+				}
+			}
+
+			void Remove(Uint32 index)
+			{
+				Item& item = Items[index];
+
+				// Moves the following items of the probe sequence back into the hole, so that none of them becomes unreachable.
+				const Uint32 mask = static_cast<Uint32>(Slots.size()) - 1;
+				Uint32 hole = FindSlot(item.ItemKey, item.Tag);
+				for (Uint32 slot = (hole + 1) & mask; Slots[slot].Index != None; slot = (slot + 1) & mask)
+				{
+					const Uint32 home = Slots[slot].Tag & mask;
+					if (((slot - home) & mask) >= ((slot - hole) & mask))
+					{
+						Slots[hole] = Slots[slot];
+						hole = slot;
+					}
+				}
+				Slots[hole].Index = None;
+
+				Unlink(index);
+				item.ItemValue = Value();
+				item.Next = FreeItems;
+				FreeItems = index;
+				Size--;
+			}
+
+			void Unlink(Uint32 index)
+			{
+				Item& item = Items[index];
+				(item.Previous != None ? Items[item.Previous].Next : Newest) = item.Next;
+				(item.Next != None ? Items[item.Next].Previous : Oldest) = item.Previous;
+			}
+
+			void LinkFront(Uint32 index)
+			{
+				Item& item = Items[index];
+				item.Previous = None;
+				item.Next = Newest;
+				(Newest != None ? Items[Newest].Previous : Oldest) = index;
+				Newest = index;
+			}
+
+			size_t Size = 0;
+			std::vector<Item> Items;
+			std::vector<Slot> Slots;
+			Uint32 Newest = None, Oldest = None, FreeItems = None;
+		};
+
+		struct Color
+		{
+			const float R, G, B, A;
+
+			explicit Color(uint32_t color)
+				: R(((color >> 0) & 0xff) / 255.0f), G(((color >> 8) & 0xff) / 255.0f), B(((color >> 16) & 0xff) / 255.0f), A(((color >> 24) & 0xff) / 255.0f) { }
+			Color(float r, float g, float b, float a) : R(r), G(g), B(b), A(a) { }
+
+			Color operator*(const Color& c) const { return Color(R * c.R, G * c.G, B * c.B, A * c.A); }
+			Color operator*(float v) const { return Color(R * v, G * v, B * v, A * v); }
+			Color operator+(const Color& c) const { return Color(R + c.R, G + c.G, B + c.B, A + c.A); }
+
+			uint32_t ToInt() const
+			{
+				return	((static_cast<int>(R * 255) & 0xff) << 0)
+					  | ((static_cast<int>(G * 255) & 0xff) << 8)
+					  | ((static_cast<int>(B * 255) & 0xff) << 16)
+					  | ((static_cast<int>(A * 255) & 0xff) << 24);
+			}
+
+			void UseAsDrawColor(SDL_Renderer* renderer) const
+			{
+				SDL_SetRenderDrawColor(renderer,
+					static_cast<uint8_t>(R * 255),
+					static_cast<uint8_t>(G * 255),
+					static_cast<uint8_t>(B * 255),
+					static_cast<uint8_t>(A * 255));
+			}
+		};
+
+		// Pixels on the CPU side are packed the same way as ImGui packs its colors (red in the lowest byte). This matches SDL_PIXELFORMAT_ABGR8888.
+		ImU32 PackColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+		{
+			return (static_cast<ImU32>(r) << 0) | (static_cast<ImU32>(g) << 8) | (static_cast<ImU32>(b) << 16) | (static_cast<ImU32>(a) << 24);
+		}
+
+		// Multiplies two packed colors channel by channel, which is what SDL does with the texture color and alpha mods.
+		ImU32 Modulate(ImU32 first, ImU32 second)
+		{
+			ImU32 result = 0;
+			for (int shift = 0; shift < 32; shift += 8)
+			{
+				const ImU32 product = ((first >> shift) & 0xff) * ((second >> shift) & 0xff);
+				result |= ((product + 127) / 255) << shift;
+			}
+			return result;
+		}
+
+		// Blends a color with straight (not premultiplied) alpha over another one. Blending the result onto a target with SDL_BLENDMODE_BLEND gives the
+		// same as blending the two colors onto it one after another.
+		ImU32 BlendOver(ImU32 destination, ImU32 source)
+		{
+			const ImU32 sourceAlpha = source >> 24;
+			const ImU32 destinationAlpha = destination >> 24;
+			if (sourceAlpha == 255 || destinationAlpha == 0) return source;
+			if (sourceAlpha == 0) return destination;
+
+			// Both weights are scaled by 255, so that everything stays in integers.
+			const ImU32 sourceWeight = sourceAlpha * 255;
+			const ImU32 destinationWeight = destinationAlpha * (255 - sourceAlpha);
+			const ImU32 total = sourceWeight + destinationWeight;
+
+			ImU32 result = ((total + 127) / 255) << 24;
+			for (int shift = 0; shift < 24; shift += 8)
+			{
+				const ImU32 channel = ((source >> shift) & 0xff) * sourceWeight + ((destination >> shift) & 0xff) * destinationWeight;
+				result |= ((channel + total / 2) / total) << shift;
+			}
+			return result;
+		}
+
+		// A CPU side copy of a texture that triangles can sample from.
+		struct PixelSource
+		{
+			std::vector<ImU32> Pixels;
+			int Width = 0, Height = 0;
+		};
+
+		// A CPU side buffer that triangles are rasterized into. The pitch is in pixels.
+		struct PixelBuffer
+		{
+			ImU32* Pixels;
+			int Width, Height, Pitch;
+		};
+
+		// Everything needed to rasterize a triangle. It's calculated once by SetupTriangle and then shared by all the different ways of drawing triangles.
+		struct TriangleSetup
+		{
+			// Range of pixels that are possibly covered by the triangle (inclusive).
+			int MinX, MinY, MaxX, MaxY;
+
+			// Biased barycentric coordinates at the center of the pixel (MinX, MinY), and how much they change when moving one pixel rightwards (A)
+			// or downwards (B).
+			Sint32 W1, W2, W3;
+			Sint32 A1, A2, A3;
+			Sint32 B1, B2, B3;
+			Sint32 Bias1, Bias2, Bias3;
+
+			// Normalized vertex attributes, indexed by vertex.
+			float R[3], G[3], B[3], A[3];
+			float U[3], V[3];
+
+			bool IsUniformColor;
+			ImU32 UniformColor;
+		};
+
+		class RenderState;
+		size_t DrawTriangle(RenderState& state, ImGuiSDL::Stats& stats, ImDrawVert v1, ImDrawVert v2, ImDrawVert v3, SDL_Texture* texture, const SDL_Point& offset,
+			const SDL_Rect& clip);
+		size_t RasterizeTriangle(const ImDrawVert& v1, const ImDrawVert& v2, const ImDrawVert& v3, const PixelSource* texture, const PixelBuffer& target);
+		size_t FillConvexPolygon(const ImDrawVert* vertices, unsigned int points, unsigned int stride, ImU32 color, const PixelBuffer& target);
+
+		// Keeps textures that are no longer needed around for a frame, so that a texture of the same size can be reused instead of destroying one and
+		// creating another, which makes some drivers stall. Textures that weren't reused by the end of the next frame are destroyed.
+		class TexturePool
+		{
+		public:
+			explicit TexturePool(SDL_Renderer* renderer) : Renderer(renderer) { }
+
+			~TexturePool()
+			{
+				for (const Entry& entry : Entries) SDL_DestroyTexture(entry.Texture);
+			}
+
+			TexturePool(const TexturePool&) = delete;
+			TexturePool& operator=(const TexturePool&) = delete;
+
+			// Returns a released texture with exactly this size, format and access, or creates a new one. Reused textures keep their old contents.
+			SDL_Texture* Acquire(int width, int height, Uint32 format, SDL_TextureAccess access)
+			{
+				for (size_t i = 0; i < Entries.size(); i++)
+				{
+					const Entry& entry = Entries[i];
+					if (entry.Width != width || entry.Height != height || entry.Format != format || entry.Access != access) continue;
+
+					SDL_Texture* texture = entry.Texture;
+					Bytes -= GetBytes(entry.Width, entry.Height);
+					Entries.erase(Entries.begin() + i);
+					return texture;
+				}
+
+				SDL_Texture* texture = SDL_CreateTexture(Renderer, format, access, width, height);
+				if (texture) SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+				return texture;
+			}
+
+			// Hands a texture back for reuse. Its color and alpha mods are reset, so reused textures look the same as new ones.
+			void Release(SDL_Texture* texture)
+			{
+				Entry entry = { texture, 0, 0, 0, SDL_TEXTUREACCESS_STATIC, Frame };
+				int access = 0;
+				if (SDL_QueryTexture(texture, &entry.Format, &access, &entry.Width, &entry.Height) != 0)
+				{
+					SDL_DestroyTexture(texture);
+					return;
+				}
+				entry.Access = static_cast<SDL_TextureAccess>(access);
+
+				SDL_SetTextureColorMod(texture, 255, 255, 255);
+				SDL_SetTextureAlphaMod(texture, 255);
+
+				Bytes += GetBytes(entry.Width, entry.Height);
+				Entries.push_back(entry);
+			}
+
+			// Destroys the textures that were released before the frame that just ended, and weren't reused during it.
+			void EndFrame()
+			{
+				for (size_t i = 0; i < Entries.size();)
+				{
+					if (Entries[i].Frame == Frame)
+					{
+						i++;
+						continue;
+					}
+
+					SDL_DestroyTexture(Entries[i].Texture);
+					Bytes -= GetBytes(Entries[i].Width, Entries[i].Height);
+					Entries.erase(Entries.begin() + i);
+				}
+				Frame++;
+			}
+
+			size_t GetBytes() const { return Bytes; }
+			size_t GetCount() const { return Entries.size(); }
+
+			// Rounds a size up to its size class. Textures that are rounded the same way can be reused for each other.
+			static int GetSizeClass(int size) { return (size + 63) & ~63; }
+
+		private:
+			struct Entry
+			{
+				SDL_Texture* Texture;
+				Uint32 Format;
+				int Width, Height;
+				SDL_TextureAccess Access;
+				unsigned int Frame;
+			};
+
+			static size_t GetBytes(int width, int height) { return static_cast<size_t>(width) * height * sizeof(ImU32); }
+
+			SDL_Renderer* Renderer;
+			std::vector<Entry> Entries;
+			size_t Bytes = 0;
+			unsigned int Frame = 0;
+		};
+
+		// Cached triangles are packed into a few large render target pages instead of getting a texture each. This keeps the number of texture objects
+		// low, and lets SDL batch consecutive copies from the same page. Every page is split into shelves (rows of a fixed height) that hand out
+		// regions from left to right. Freed regions are merged back into the free spans of their shelf, and empty pages are destroyed.
+		class TextureAtlas
+		{
+		public:
+			struct Page;
+
+			struct Region
+			{
+				Page* Owner = nullptr;
+				int Shelf = 0;
+				SDL_Rect Rect = { 0, 0, 0, 0 };
+			};
+
+			// Pages that are drawn to by SDL have to be render targets, while pages filled by the CPU rasterizer are streaming textures.
+			TextureAtlas(SDL_Renderer* renderer, TexturePool& pool, Uint32 format, SDL_TextureAccess access) : Pool(pool), Format(format), Access(access)
+			{
+				SDL_RendererInfo info;
+				if (SDL_GetRendererInfo(renderer, &info) == 0)
+				{
+					if (info.max_texture_width > 0) PageSize = std::min(PageSize, info.max_texture_width);
+					if (info.max_texture_height > 0) PageSize = std::min(PageSize, info.max_texture_height);
+				}
+			}
+
+			~TextureAtlas()
+			{
+				for (const auto& page : Pages) SDL_DestroyTexture(page->Texture);
+			}
+
+			TextureAtlas(const TextureAtlas&) = delete;
+			TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+			// Regions larger than this would waste too much of a page, those should get a texture of their own.
+			int GetMaxRegionSize() const { return PageSize / 4; }
+
+			SDL_Texture* GetTexture(const Region& region) const { return region.Owner->Texture; }
+
+			size_t GetPageCount() const { return Pages.size(); }
+			size_t GetBytes() const { return Pages.size() * PageSize * PageSize * sizeof(ImU32); }
+
+			bool Allocate(int width, int height, Region& region)
+			{
+				if (width > GetMaxRegionSize() || height > GetMaxRegionSize()) return false;
+
+				for (const auto& page : Pages)
+				{
+					if (Allocate(*page, width, height, region)) return true;
+				}
+
+				auto page = std::make_unique<Page>();
+				page->Texture = Pool.Acquire(PageSize, PageSize, Format, Access);
+				if (!page->Texture) return false;
+
+				Pages.push_back(std::move(page));
+				return Allocate(*Pages.back(), width, height, region);
+			}
+
+			void Free(const Region& region)
+			{
+				Page& page = *region.Owner;
+				Shelf& shelf = page.Shelves[region.Shelf];
+
+				// Insert the region back into the sorted free spans, merging it with its neighbours.
+				const auto next = std::lower_bound(shelf.Free.begin(), shelf.Free.end(), region.Rect.x, [](const Span& span, int x) { return span.X < x; });
+				const auto inserted = shelf.Free.insert(next, Span{ region.Rect.x, region.Rect.w });
+				if (inserted + 1 != shelf.Free.end() && inserted->X + inserted->Width == (inserted + 1)->X)
+				{
+					inserted->Width += (inserted + 1)->Width;
+					shelf.Free.erase(inserted + 1);
+				}
+				if (inserted != shelf.Free.begin() && (inserted - 1)->X + (inserted - 1)->Width == inserted->X)
+				{
+					(inserted - 1)->Width += inserted->Width;
+					shelf.Free.erase(inserted);
+				}
+
+				shelf.Allocations--;
+				page.Allocations--;
+
+				// Empty shelves at the bottom of the page give their space back, so it can be used for shelves of a different height.
+				while (!page.Shelves.empty() && page.Shelves.back().Allocations == 0)
+				{
+					page.UsedHeight -= page.Shelves.back().Height;
+					page.Shelves.pop_back();
+				}
+
+				// Always keep one page around, it will most likely be needed again soon.
+				if (page.Allocations == 0 && Pages.size() > 1)
+				{
+					const auto location = std::find_if(Pages.begin(), Pages.end(), [&page](const std::unique_ptr<Page>& p) { return p.get() == &page; });
+					Pool.Release(page.Texture);
+					Pages.erase(location);
+				}
+			}
+
+		private:
+			struct Span
+			{
+				int X, Width;
+			};
+
+			struct Shelf
+			{
+				int Y, Height;
+				int Allocations;
+				std::vector<Span> Free;
+			};
+
+		public:
+			struct Page
+			{
+				SDL_Texture* Texture = nullptr;
+				int UsedHeight = 0;
+				int Allocations = 0;
+				std::vector<Shelf> Shelves;
+				// The color and alpha mod that the texture was last drawn with.
+				ImU32 Tint = 0xffffffff;
+			};
+
+		private:
+			TexturePool& Pool;
+			Uint32 Format;
+			SDL_TextureAccess Access;
+			int PageSize = 1024;
+			std::vector<std::unique_ptr<Page>> Pages;
+
+			bool Allocate(Page& page, int width, int height, Region& region)
+			{
+				// Shelf heights are rounded up, so that triangles of a similar height can share a shelf.
+				const int shelfHeight = (height + 7) & ~7;
+
+				// Pick the lowest shelf that still has room, but don't put small regions into shelves that are much taller than them (unless the shelf
+				// is completely empty).
+				int bestShelf = -1;
+				size_t bestSpan = 0;
+				for (size_t i = 0; i < page.Shelves.size(); i++)
+				{
+					const Shelf& shelf = page.Shelves[i];
+					if (shelf.Height < height || (shelf.Allocations > 0 && shelf.Height > shelfHeight * 2)) continue;
+					if (bestShelf >= 0 && page.Shelves[bestShelf].Height <= shelf.Height) continue;
+
+					for (size_t j = 0; j < shelf.Free.size(); j++)
+					{
+						if (shelf.Free[j].Width >= width)
+						{
+							bestShelf = static_cast<int>(i);
+							bestSpan = j;
+							break;
+						}
+					}
+				}
+
+				if (bestShelf < 0)
+				{
+					if (page.UsedHeight + shelfHeight > PageSize) return false;
+
+					page.Shelves.push_back(Shelf{ page.UsedHeight, shelfHeight, 0, { Span{ 0, PageSize } } });
+					page.UsedHeight += shelfHeight;
+					bestShelf = static_cast<int>(page.Shelves.size()) - 1;
+					bestSpan = 0;
+				}
+
+				Shelf& shelf = page.Shelves[bestShelf];
+				Span& span = shelf.Free[bestSpan];
+				region.Owner = &page;
+				region.Shelf = bestShelf;
+				region.Rect = { span.X, shelf.Y, width, height };
+
+				span.X += width;
+				span.Width -= width;
+				if (span.Width == 0) shelf.Free.erase(shelf.Free.begin() + bestSpan);
+
+				shelf.Allocations++;
+				page.Allocations++;
+				return true;
+			}
+		};
+
+		// A fixed set of threads that run the iterations of a loop in parallel. The thread calling Run takes part in the work as well, so a pool with a
+		// thread count of one doesn't start any threads at all.
+		class WorkerPool
+		{
+		public:
+			explicit WorkerPool(int threadCount)
+			{
+				for (int i = 1; i < threadCount; i++) Threads.emplace_back([this] { Work(); });
+			}
+
+			~WorkerPool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Stopping = true;
+				}
+				Wake.notify_all();
+				for (auto& thread : Threads) thread.join();
+			}
+
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool& operator=(const WorkerPool&) = delete;
+
+			int GetThreadCount() const { return static_cast<int>(Threads.size()) + 1; }
+
+			// Calls the function once for every index in [0, count) and returns when all calls are done. Indices are handed out one at a time, so
+			// uneven amounts of work per index are balanced between the threads.
+			void Run(int count, const std::function<void(int)>& function)
+			{
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Job = &function;
+					JobCount = count;
+					NextIndex = 0;
+					Working = static_cast<int>(Threads.size());
+					Generation++;
+				}
+				Wake.notify_all();
+
+				RunJob(function, count);
+
+				std::unique_lock<std::mutex> lock(Mutex);
+				Done.wait(lock, [this] { return Working == 0; });
+			}
+
+		private:
+			void RunJob(const std::function<void(int)>& function, int count)
+			{
+				for (int i = NextIndex++; i < count; i = NextIndex++) function(i);
+			}
+
+			void Work()
+			{
+				unsigned int generation = 0;
+				std::unique_lock<std::mutex> lock(Mutex);
+				while (true)
+				{
+					Wake.wait(lock, [&] { return Stopping || Generation != generation; });
+					if (Stopping) return;
+
+					generation = Generation;
+					const std::function<void(int)>& function = *Job;
+					const int count = JobCount;
+
+					lock.unlock();
+					RunJob(function, count);
+					lock.lock();
+
+					if (--Working == 0) Done.notify_one();
+				}
+			}
+
+			std::vector<std::thread> Threads;
+			std::mutex Mutex;
+			std::condition_variable Wake, Done;
+
+			const std::function<void(int)>* Job = nullptr;
+			int JobCount = 0;
+			std::atomic<int> NextIndex{ 0 };
+			int Working = 0;
+			unsigned int Generation = 0;
+			bool Stopping = false;
+		};
+
+		// Rasterizes whole frames on the CPU. Triangles and solid rectangles are binned into square tiles of the screen, and the tiles are rasterized in
+		// parallel. Every tile keeps its primitives in submission order and blends them over each other, so the result is the same as drawing them one
+		// after another. The pixels end up with straight alpha, ready to be blended onto the render target in one go.
+		class FrameRasterizer
+		{
+		public:
+			static constexpr int TileSize = 64;
+
+			// Starts over with an empty frame buffer of the given size.
+			void Begin(int width, int height);
+
+			// Bins the triangles of a draw command. The texture is the CPU copy of the texture used by the command, if it has one, and triangles that
+			// only sample its white pixel are untextured.
+			void AddCommand(const ImDrawVert* vertices, const ImDrawIdx* indices, unsigned int indexCount, const PixelSource* texture, const ImVec2& whitePixel,
+				const SDL_Rect& clip);
+
+			// Rasterizes everything that was added since Begin, and returns the area of the frame buffer that was drawn to. Pixels outside of it are
+			// left as they were.
+			SDL_Rect Rasterize(WorkerPool& workers);
+
+			bool IsEmpty() const { return Primitives.empty(); }
+			// The number of pixels that were rasterized since Begin.
+			size_t GetRasterizedPixels() const { return RasterizedPixels; }
+			int GetWidth() const { return Width; }
+			int GetHeight() const { return Height; }
+			const ImU32* GetPixels() const { return Pixels.data(); }
+
+		private:
+			struct Primitive
+			{
+				// The pixels that may be covered, already clipped to the clip rect of the draw command and to the frame buffer.
+				SDL_Rect Bounds;
+
+				// Solid rectangles are filled with their color, everything else is rasterized from the triangle setup.
+				bool IsRect;
+				ImU32 Color;
+				const PixelSource* Texture;
+				TriangleSetup Setup;
+			};
+
+			void Add(const Primitive& primitive);
+			void RasterizeTile(int tile);
+
+			int Width = 0, Height = 0;
+			int Columns = 0, Rows = 0;
+			std::vector<ImU32> Pixels;
+
+			std::vector<Primitive> Primitives;
+			// Indices into the primitives for every tile, in submission order.
+			std::vector<std::vector<Uint32>> Bins;
+			SDL_Rect Dirty = { 0, 0, 0, 0 };
+			std::atomic<size_t> RasterizedPixels{ 0 };
+		};
+
+		// Copies a buffer into one that keeps its capacity between frames. Assigning an ImVector frees its memory first, so it would allocate every time.
+		template <typename T>
+		void CopyBuffer(const ImVector<T>& source, ImVector<T>& copy)
+		{
+			copy.resize(source.Size);
+			if (source.Size > 0) std::memcpy(copy.Data, source.Data, static_cast<size_t>(source.Size) * sizeof(T));
+		}
+
+		// Copies a draw list, with the origin of its positions and clip rects moved to the given point and then multiplied by the scale. The origin is
+		// the DisplayPos of the draw data, which is only non-zero for the secondary windows of ImGui's multi-viewport branch. The copy reuses the
+		// buffers it had, so copying the same draw list every frame doesn't allocate once they're big enough.
+		void CopyDrawList(const ImDrawList& source, ImDrawList& copy, const ImVec2& origin, const ImVec2& scale)
+		{
+			CopyBuffer(source.CmdBuffer, copy.CmdBuffer);
+			CopyBuffer(source.IdxBuffer, copy.IdxBuffer);
+			if (origin.x == 0.0f && origin.y == 0.0f && scale.x == 1.0f && scale.y == 1.0f)
+			{
+				CopyBuffer(source.VtxBuffer, copy.VtxBuffer);
+				return;
+			}
+
+			// The vertices are moved while they're copied, instead of going over the copy a second time.
+			copy.VtxBuffer.resize(source.VtxBuffer.Size);
+			for (int i = 0; i < source.VtxBuffer.Size; i++)
+			{
+				ImDrawVert vertex = source.VtxBuffer.Data[i];
+				vertex.pos.x = (vertex.pos.x - origin.x) * scale.x;
+				vertex.pos.y = (vertex.pos.y - origin.y) * scale.y;
+				copy.VtxBuffer.Data[i] = vertex;
+			}
+			for (ImDrawCmd& command : copy.CmdBuffer)
+			{
+				command.ClipRect = ImVec4((command.ClipRect.x - origin.x) * scale.x, (command.ClipRect.y - origin.y) * scale.y,
+					(command.ClipRect.z - origin.x) * scale.x, (command.ClipRect.w - origin.y) * scale.y);
+			}
+		}
+
+		// Rasterizes submitted frames with the frame rasterizer on a background thread, so that the rasterization overlaps with whatever the application
+		// does until it composites the frame. Two frames take turns: while one is rasterized or waits to be composited, the next one can be submitted.
+		class AsyncRenderer
+		{
+		public:
+			// A step of a rasterized frame in draw order. Either a layer of the frame rasterizer, or a draw command that SDL has to draw, because it
+			// uses one of your own textures or a callback.
+			struct Step
+			{
+				int Layer;
+				const ImDrawList* List;
+				const ImDrawCmd* Command;
+				const ImDrawIdx* Indices;
+				SDL_Rect Clip;
+			};
+
+			struct Frame
+			{
+				// The copied draw data, in pixels of the frame.
+				std::vector<std::unique_ptr<ImDrawList>> Lists;
+				int ListCount = 0;
+				int Width = 0, Height = 0;
+
+				// What the worker needs to know about the font, copied when the frame is submitted. The font pixels stay where they are, so the font
+				// can't change until the worker is done (see Wait).
+				const PixelSource* FontPixels = nullptr;
+				ImVec2 WhitePixel;
+				int ThreadCount = 1;
+
+				// Filled in by the worker. The layers are kept between frames, so that their frame buffers don't have to be allocated again.
+				std::vector<Step> Steps;
+				std::vector<std::unique_ptr<FrameRasterizer>> Layers;
+				std::vector<SDL_Rect> LayerAreas;
+				size_t TrianglesSubmitted = 0;
+				size_t PixelsRasterized = 0;
+				double RasterizationTime = 0.0;
+			};
+
+			AsyncRenderer() = default;
+			AsyncRenderer(const AsyncRenderer&) = delete;
+			AsyncRenderer& operator=(const AsyncRenderer&) = delete;
+
+			~AsyncRenderer()
+			{
+				if (!Thread.joinable()) return;
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Stopping = true;
+				}
+				Changed.notify_all();
+				Thread.join();
+			}
+
+			// Returns the frame to copy the draw data into. Waits for the worker if the frame is still being rasterized, and drops it if it was never
+			// composited.
+			Frame& BeginSubmit()
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				if (!Thread.joinable()) Thread = std::thread([this] { Work(); });
+
+				Changed.wait(lock, [this] { return States[Next] != FrameState::Queued && States[Next] != FrameState::Compositing; });
+				States[Next] = FrameState::Empty;
+				return Frames[Next];
+			}
+
+			// Hands the frame of BeginSubmit to the worker.
+			void EndSubmit()
+			{
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					States[Next] = FrameState::Queued;
+					Queue.push_back(Next);
+					Previous = Latest;
+					Latest = Next;
+					Next = 1 - Next;
+				}
+				Changed.notify_all();
+			}
+
+			// Waits until the most recently submitted frame, or the one before it with a latency of one, is rasterized. Returns null if there is no such
+			// frame, or if it was composited already.
+			Frame* BeginComposite(int latency)
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				const int index = latency > 0 ? Previous : Latest;
+				if (index < 0 || States[index] == FrameState::Empty) return nullptr;
+
+				Changed.wait(lock, [&] { return States[index] == FrameState::Ready; });
+				States[index] = FrameState::Compositing;
+				Compositing = index;
+				return &Frames[index];
+			}
+
+			void EndComposite()
+			{
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					States[Compositing] = FrameState::Empty;
+				}
+				Changed.notify_all();
+			}
+
+			// Waits until the worker is done with every submitted frame.
+			void Wait()
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				Changed.wait(lock, [this] { return States[0] != FrameState::Queued && States[1] != FrameState::Queued; });
+			}
+
+		private:
+			enum class FrameState { Empty, Queued, Ready, Compositing };
+
+			void Work()
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				while (true)
+				{
+					Changed.wait(lock, [this] { return Stopping || !Queue.empty(); });
+					if (Stopping) return;
+
+					const int index = Queue.front();
+					Queue.erase(Queue.begin());
+
+					lock.unlock();
+					Rasterize(Frames[index]);
+					lock.lock();
+
+					States[index] = FrameState::Ready;
+					Changed.notify_all();
+				}
+			}
+
+			// Bins the commands of the frame into layers of the frame rasterizer and rasterizes them. Every command that the frame rasterizer can't draw
+			// ends the current layer, so that SDL can draw it in between.
+			void Rasterize(Frame& frame)
+			{
+				frame.RasterizationTime = 0.0;
+				ScopedTimer timer(frame.RasterizationTime);
+				frame.Steps.clear();
+				frame.TrianglesSubmitted = frame.PixelsRasterized = 0;
+
+				if (!Workers || Workers->GetThreadCount() != frame.ThreadCount) Workers = std::make_unique<WorkerPool>(frame.ThreadCount);
+
+				const SDL_Rect screen = { 0, 0, frame.Width, frame.Height };
+				FrameRasterizer* layer = nullptr;
+				size_t layerCount = 0;
+				for (int n = 0; n < frame.ListCount; n++)
+				{
+					const ImDrawList* list = frame.Lists[n].get();
+					const ImDrawIdx* indices = list->IdxBuffer.Data;
+					for (const ImDrawCmd& command : list->CmdBuffer)
+					{
+						const SDL_Rect commandClip = GetClipRect(command.ClipRect);
+						SDL_Rect clip;
+						const bool isVisible = SDL_IntersectRect(&commandClip, &screen, &clip) == SDL_TRUE;
+						const bool isFont = IsFontTexture(command.TextureId);
+
+						if (!command.UserCallback) frame.TrianglesSubmitted += command.ElemCount / 3;
+						if (!command.UserCallback && (isFont || !command.TextureId))
+						{
+							if (isVisible)
+							{
+								if (!layer)
+								{
+									if (frame.Layers.size() <= layerCount) frame.Layers.push_back(std::make_unique<FrameRasterizer>());
+									layer = frame.Layers[layerCount].get();
+									layer->Begin(frame.Width, frame.Height);
+									frame.Steps.push_back(Step{ static_cast<int>(layerCount++), nullptr, nullptr, nullptr, screen });
+								}
+								layer->AddCommand(list->VtxBuffer.Data, indices, command.ElemCount, isFont ? frame.FontPixels : nullptr, frame.WhitePixel, clip);
+							}
+						}
+						else
+						{
+							if (layer) FinishLayer(frame, layerCount - 1);
+							layer = nullptr;
+							if (isVisible) frame.Steps.push_back(Step{ -1, list, &command, indices, clip });
+						}
+
+						indices += command.ElemCount;
+					}
+				}
+				if (layer) FinishLayer(frame, layerCount - 1);
+			}
+
+			void FinishLayer(Frame& frame, size_t index)
+			{
+				FrameRasterizer& layer = *frame.Layers[index];
+				frame.LayerAreas.resize(std::max(frame.LayerAreas.size(), index + 1));
+				frame.LayerAreas[index] = layer.IsEmpty() ? SDL_Rect{ 0, 0, 0, 0 } : layer.Rasterize(*Workers);
+				frame.PixelsRasterized += layer.GetRasterizedPixels();
+			}
+
+			Frame Frames[2];
+			FrameState States[2] = { FrameState::Empty, FrameState::Empty };
+			// Indices of the frames: the one the next submit goes into, the two most recently submitted ones, and the one being composited.
+			int Next = 0, Latest = -1, Previous = -1, Compositing = -1;
+			std::vector<int> Queue;
+
+			std::thread Thread;
+			std::mutex Mutex;
+			std::condition_variable Changed;
+			bool Stopping = false;
+			// The worker's own threads for rasterizing tiles, so that it doesn't get in the way of the device's.
+			std::unique_ptr<WorkerPool> Workers;
+		};
+
+		// Finds the parts of the screen that changed since the previous frame. Draw lists are compared by their position in the draw data, and a
+		// draw list that changed in any way damages the area it covered in the previous frame and the area it covers now. The area of a draw list is
+		// the union of the clip rects of its commands, nothing of it can be drawn outside of those.
+		class DamageTracker
+		{
+		public:
+			// Makes the next update damage everything, for when the previously drawn contents are gone.
+			void Invalidate() { IsValid = false; }
+
+			// Compares the draw data with the previous frame and collects the damaged rectangles. Returns false if nothing was damaged.
+			bool Update(const ImDrawData* drawData, int width, int height)
+			{
+				Rects.clear();
+
+				const SDL_Rect screen = { 0, 0, width, height };
+				if (!IsValid || width != Width || height != Height)
+				{
+					Lists.clear();
+					if (width > 0 && height > 0) Rects.push_back(screen);
+					IsValid = true;
+					Width = width;
+					Height = height;
+				}
+
+				Current.clear();
+				for (int i = 0; i < drawData->CmdListsCount; i++) Current.push_back(Measure(*drawData->CmdLists[i], screen));
+
+				for (size_t i = 0; i < std::max(Current.size(), Lists.size()); i++)
+				{
+					const bool existed = i < Lists.size(), exists = i < Current.size();
+					if (existed && exists && Current[i].Hash == Lists[i].Hash && !Current[i].IsVolatile) continue;
+
+					if (existed) AddRect(Lists[i].Bounds);
+					if (exists) AddRect(Current[i].Bounds);
+				}
+				Lists.swap(Current);
+
+				return !Rects.empty();
+			}
+
+			const std::vector<SDL_Rect>& GetRects() const { return Rects; }
+
+		private:
+			// More rectangles than this are merged into one, at some point drawing the commands again for every rectangle costs more than it saves.
+			static constexpr size_t MaxRects = 8;
+
+			struct ListState
+			{
+				Uint64 Hash;
+				SDL_Rect Bounds;
+				// Callbacks can draw something different every frame without the draw list changing, so lists with callbacks are always damaged.
+				bool IsVolatile;
+			};
+
+			static ListState Measure(const ImDrawList& list, const SDL_Rect& screen)
+			{
+				ListState state = {};
+				state.Hash = HashBytes(list.VtxBuffer.Data, list.VtxBuffer.Size * sizeof(ImDrawVert), 0);
+				state.Hash = HashBytes(list.IdxBuffer.Data, list.IdxBuffer.Size * sizeof(ImDrawIdx), state.Hash);
+
+				for (const ImDrawCmd& command : list.CmdBuffer)
+				{
+					const struct
+					{
+						float ClipRect[4];
+						Uint64 TextureId, ElemCount;
+					} key = { { command.ClipRect.x, command.ClipRect.y, command.ClipRect.z, command.ClipRect.w },
+						reinterpret_cast<uintptr_t>(command.TextureId), command.ElemCount };
+					state.Hash = HashBytes(&key, sizeof(key), state.Hash);
+					state.IsVolatile |= command.UserCallback != nullptr;
+
+					const SDL_Rect clip = GetClipRect(command.ClipRect);
+
+					SDL_Rect visible;
+					if (!SDL_IntersectRect(&clip, &screen, &visible)) continue;
+					if (SDL_RectEmpty(&state.Bounds)) state.Bounds = visible;
+					else SDL_UnionRect(&state.Bounds, &visible, &state.Bounds);
+				}
+				return state;
+			}
+
+			void AddRect(SDL_Rect rect)
+			{
+				if (SDL_RectEmpty(&rect)) return;
+
+				// Overlapping rectangles are merged, the merged one can overlap others again.
+				for (size_t i = 0; i < Rects.size();)
+				{
+					if (SDL_HasIntersection(&Rects[i], &rect))
+					{
+						SDL_UnionRect(&Rects[i], &rect, &rect);
+						Rects.erase(Rects.begin() + i);
+						i = 0;
+					}
+					else i++;
+				}
+				Rects.push_back(rect);
+
+				if (Rects.size() > MaxRects)
+				{
+					for (const SDL_Rect& other : Rects) SDL_UnionRect(&rect, &other, &rect);
+					Rects.assign(1, rect);
+				}
+			}
+
+			bool IsValid = false;
+			int Width = 0, Height = 0;
+			std::vector<ListState> Lists, Current;
+			std::vector<SDL_Rect> Rects;
+		};
+
+		// Keeps whole draw lists (usually one window each) rendered into textures of their own, so that a draw list that didn't change since it was
+		// cached, or only moved by whole pixels, is drawn with a single copy. Draw lists are identified by a hash of their buffers, with all positions
+		// made relative to the top left corner of the area the draw list covers. Only draw lists that looked the same in the previous frame are cached,
+		// everything else most likely changes every frame and would just waste the time spent on rendering it into a texture.
+		class DrawListCache
+		{
+		public:
+			struct Item
+			{
+				SDL_Texture* Texture = nullptr;
+				size_t Bytes = 0;
+
+				~Item()
+				{
+					if (Texture) SDL_DestroyTexture(Texture);
+				}
+			};
+
+			// Measures and hashes a draw list, and makes a copy of its vertices that is moved to the origin of the list. Returns false if the draw list
+			// can't be cached, which is the case for lists with callbacks, since those can draw something different every frame.
+			bool Prepare(const ImDrawList& list, const SDL_Rect& screen, SDL_Rect& bounds, Uint64& hash)
+			{
+				bounds = { 0, 0, 0, 0 };
+				for (const ImDrawCmd& command : list.CmdBuffer)
+				{
+					if (command.UserCallback) return false;
+
+					const SDL_Rect clip = GetClipRect(command.ClipRect);
+
+					SDL_Rect visible;
+					if (!SDL_IntersectRect(&clip, &screen, &visible)) continue;
+					if (SDL_RectEmpty(&bounds)) bounds = visible;
+					else SDL_UnionRect(&bounds, &visible, &bounds);
+				}
+				if (SDL_RectEmpty(&bounds)) return false;
+
+				const float originX = static_cast<float>(bounds.x), originY = static_cast<float>(bounds.y);
+				Vertices.assign(list.VtxBuffer.Data, list.VtxBuffer.Data + list.VtxBuffer.Size);
+				for (ImDrawVert& vertex : Vertices)
+				{
+					vertex.pos.x -= originX;
+					vertex.pos.y -= originY;
+				}
+
+				hash = HashBytes(Vertices.data(), Vertices.size() * sizeof(ImDrawVert), 0);
+				hash = HashBytes(list.IdxBuffer.Data, list.IdxBuffer.Size * sizeof(ImDrawIdx), hash);
+				for (const ImDrawCmd& command : list.CmdBuffer)
+				{
+					const struct
+					{
+						float ClipRect[4];
+						Uint64 TextureId, ElemCount;
+					} key = { { command.ClipRect.x - originX, command.ClipRect.y - originY, command.ClipRect.z - originX, command.ClipRect.w - originY },
+						reinterpret_cast<uintptr_t>(command.TextureId), command.ElemCount };
+					hash = HashBytes(&key, sizeof(key), hash);
+				}
+
+				// The size is part of the hash too, a list that is cut off by the edge of the screen doesn't fit into the texture of the whole list.
+				const int size[2] = { bounds.w, bounds.h };
+				hash = HashBytes(size, sizeof(size), hash);
+
+				Seen[Frame].push_back(hash);
+				return true;
+			}
+
+			// The vertices of the last prepared draw list, relative to its origin.
+			const std::vector<ImDrawVert>& GetVertices() const { return Vertices; }
+
+			const Item* Find(Uint64 hash)
+			{
+				const std::unique_ptr<Item>* item = Items.TryGet(hash);
+				return item ? item->get() : nullptr;
+			}
+
+			bool WasSeenLastFrame(Uint64 hash) const
+			{
+				const std::vector<Uint64>& previous = Seen[1 - Frame];
+				return std::find(previous.begin(), previous.end(), hash) != previous.end();
+			}
+
+			// Adds a rendered draw list, and evicts the least recently used ones until everything fits into the budget again.
+			void Insert(Uint64 hash, std::unique_ptr<Item> item, size_t budget)
+			{
+				Bytes += item->Bytes;
+				Items.Insert(hash, std::move(item));
+
+				while (Bytes > budget)
+				{
+					std::unique_ptr<Item> evicted = Items.EvictLeastRecent();
+					if (!evicted) break;
+					Bytes -= evicted->Bytes;
+				}
+			}
+
+			void EndFrame()
+			{
+				Frame = 1 - Frame;
+				Seen[Frame].clear();
+			}
+
+			size_t GetCount() const { return Items.GetSize(); }
+			size_t GetBytes() const { return Bytes; }
+
+			void Reset()
+			{
+				Items.Reset();
+				Bytes = 0;
+				Seen[0].clear();
+				Seen[1].clear();
+			}
+
+		private:
+			LRUCache<Uint64, std::unique_ptr<Item>> Items;
+			size_t Bytes = 0;
+
+			// The hashes of the draw lists of this and the previous frame. There are only a few draw lists per frame, so a plain search is fastest.
+			std::vector<Uint64> Seen[2];
+			int Frame = 0;
+
+			std::vector<ImDrawVert> Vertices;
+		};
+
+		// Keeps track of the state of the renderer and of the color and alpha mods of textures, and only passes actual changes on to SDL. Most of
+		// these calls make SDL flush the draw calls it batched so far, so skipping the redundant ones keeps the batches long. End restores the state
+		// the renderer was in when Begin was called, along with the mods of every texture that was changed in between.
+		class RenderState
+		{
+		public:
+			RenderState(SDL_Renderer* renderer, size_t& calls) : Renderer(renderer), Calls(calls) {}
+
+			void Begin()
+			{
+				Refresh();
+				Initial = Current;
+			}
+
+			void End()
+			{
+				RestoreTextureMods();
+				SetTarget(Initial.Target);
+				SetClipRect(Initial.ClipEnabled ? &Initial.Clip : nullptr);
+				SetDrawColor(Initial.DrawColor);
+				SetBlendMode(Initial.BlendMode);
+			}
+
+			// Reads the state back from the renderer, after something else (like a draw callback) may have changed it.
+			void Refresh()
+			{
+				Current.Target = SDL_GetRenderTarget(Renderer);
+				RefreshClip();
+
+				Uint8 r, g, b, a;
+				SDL_GetRenderDrawColor(Renderer, &r, &g, &b, &a);
+				Current.DrawColor = PackColor(r, g, b, a);
+				SDL_GetRenderDrawBlendMode(Renderer, &Current.BlendMode);
+			}
+
+			SDL_Renderer* GetRenderer() const { return Renderer; }
+			SDL_Texture* GetTarget() const { return Current.Target; }
+
+			void SetTarget(SDL_Texture* target)
+			{
+				if (target == Current.Target) return;
+
+				SDL_SetRenderTarget(Renderer, target);
+				Current.Target = target;
+				Calls++;
+
+				// SDL resets the clip rect for texture targets, and brings back the one of the window when switching back to it.
+				RefreshClip();
+			}
+
+			// Disables clipping if the rect is null.
+			void SetClipRect(const SDL_Rect* rect)
+			{
+				if (!rect && !Current.ClipEnabled) return;
+				if (rect && Current.ClipEnabled && SDL_RectEquals(rect, &Current.Clip)) return;
+
+				SDL_RenderSetClipRect(Renderer, rect);
+				Current.ClipEnabled = rect != nullptr;
+				if (rect) Current.Clip = *rect;
+				Calls++;
+			}
+
+			void SetDrawColor(ImU32 color)
+			{
+				if (color == Current.DrawColor) return;
+
+				SDL_SetRenderDrawColor(Renderer, (color >> 0) & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff, (color >> 24) & 0xff);
+				Current.DrawColor = color;
+				Calls++;
+			}
+
+			void SetBlendMode(SDL_BlendMode mode)
+			{
+				if (mode == Current.BlendMode) return;
+
+				SDL_SetRenderDrawBlendMode(Renderer, mode);
+				Current.BlendMode = mode;
+				Calls++;
+			}
+
+			// Sets the color and alpha mod of a texture, packed like a color. The mods the texture had before are read the first time it's changed.
+			void SetTextureMods(SDL_Texture* texture, ImU32 mods)
+			{
+				ApplyTextureMods(FindTextureMods(texture), mods);
+			}
+
+			// Gives a texture back the mods it had before it was changed, for drawing it with SDL_RenderGeometry, which modulates with the mods too.
+			void ResetTextureMods(SDL_Texture* texture)
+			{
+				for (TextureMods& entry : Textures)
+				{
+					if (entry.Texture == texture)
+					{
+						ApplyTextureMods(entry, entry.Original);
+						return;
+					}
+				}
+			}
+
+			// Restores the mods of all textures that were changed. Has to be called before the application gets to draw anything.
+			void RestoreTextureMods()
+			{
+				for (TextureMods& entry : Textures) ApplyTextureMods(entry, entry.Original);
+				Textures.clear();
+			}
+
+		private:
+			struct State
+			{
+				SDL_Texture* Target = nullptr;
+				bool ClipEnabled = false;
+				SDL_Rect Clip = { 0, 0, 0, 0 };
+				ImU32 DrawColor = 0;
+				SDL_BlendMode BlendMode = SDL_BLENDMODE_NONE;
+			};
+
+			struct TextureMods
+			{
+				SDL_Texture* Texture;
+				ImU32 Original, Current;
+			};
+
+			void RefreshClip()
+			{
+				Current.ClipEnabled = SDL_RenderIsClipEnabled(Renderer) == SDL_TRUE;
+				SDL_RenderGetClipRect(Renderer, &Current.Clip);
+			}
+
+			void ApplyTextureMods(TextureMods& entry, ImU32 mods)
+			{
+				if ((mods & 0x00ffffff) != (entry.Current & 0x00ffffff))
+				{
+					SDL_SetTextureColorMod(entry.Texture, (mods >> 0) & 0xff, (mods >> 8) & 0xff, (mods >> 16) & 0xff);
+					Calls++;
+				}
+				if ((mods >> 24) != (entry.Current >> 24))
+				{
+					SDL_SetTextureAlphaMod(entry.Texture, (mods >> 24) & 0xff);
+					Calls++;
+				}
+				entry.Current = mods;
+			}
+
+			// Only a handful of textures are used in a frame, and the one used last is almost always the one that is looked up next.
+			TextureMods& FindTextureMods(SDL_Texture* texture)
+			{
+				if (!Textures.empty() && Textures.back().Texture == texture) return Textures.back();
+
+				for (auto entry = Textures.begin(); entry != Textures.end(); ++entry)
+				{
+					if (entry->Texture == texture)
+					{
+						std::iter_swap(entry, Textures.end() - 1);
+						return Textures.back();
+					}
+				}
+
+				Uint8 r = 255, g = 255, b = 255, a = 255;
+				SDL_GetTextureColorMod(texture, &r, &g, &b);
+				SDL_GetTextureAlphaMod(texture, &a);
+				const ImU32 mods = PackColor(r, g, b, a);
+				Textures.push_back(TextureMods{ texture, mods, mods });
+				return Textures.back();
+			}
+
+			SDL_Renderer* Renderer;
+			size_t& Calls;
+			State Initial, Current;
+			std::vector<TextureMods> Textures;
+		};
+
+		// Collects the rectangle fills and texture copies of a draw command and sorts them into batches of the same texture and color, so that SDL can
+		// draw every batch at once instead of starting a new one whenever the texture or color changes. A draw joins the earliest batch that comes
+		// after every batch it overlaps, so draws that overlap are still drawn in the order they were added and blend the same.
+		class DrawQueue
+		{
+		public:
+			struct Draw
+			{
+				// Fills have no texture. Copies are tinted with the color, through the tint that the texture keeps track of itself if there is one.
+				SDL_Texture* Texture;
+				ImU32 Color;
+				ImU32* Tint;
+				SDL_Rect Source, Destination;
+				SDL_RendererFlip Flip;
+				// The next draw of the same batch, or None.
+				Uint32 Next;
+			};
+
+			struct Batch
+			{
+				SDL_Texture* Texture;
+				ImU32 Color;
+				ImU32* Tint;
+				// The union of the destinations of its draws, which rules out most batches without looking at their draws.
+				SDL_Rect Bounds;
+				Uint32 First, Last;
+			};
+
+			static constexpr Uint32 None = ~0u;
+
+			bool IsEmpty() const { return Draws.empty(); }
+			const std::vector<Batch>& GetBatches() const { return Batches; }
+			const Draw& GetDraw(Uint32 index) const { return Draws[index]; }
+
+			void Add(SDL_Texture* texture, ImU32 color, ImU32* tint, const SDL_Rect& source, const SDL_Rect& destination, SDL_RendererFlip flip)
+			{
+				const Uint32 index = static_cast<Uint32>(Draws.size());
+				Draws.push_back(Draw{ texture, color, tint, source, destination, flip, None });
+
+				// Batches are looked at from the last one backwards, up to the first one with a draw that overlaps this one. Only so many batches are
+				// looked at, so that a command with lots of small batches doesn't take quadratic time, and draws never move further back than that.
+				size_t target = Batches.size();
+				const size_t oldest = Batches.size() > MaxLookback ? Batches.size() - MaxLookback : 0;
+				for (size_t n = Batches.size(); n > oldest; n--)
+				{
+					const Batch& batch = Batches[n - 1];
+					if (Overlaps(batch, destination)) break;
+					if (batch.Texture == texture && batch.Color == color && batch.Tint == tint) target = n - 1;
+				}
+
+				if (target == Batches.size())
+				{
+					Batches.push_back(Batch{ texture, color, tint, destination, index, index });
+					return;
+				}
+
+				Batch& batch = Batches[target];
+				SDL_UnionRect(&batch.Bounds, &destination, &batch.Bounds);
+				Draws[batch.Last].Next = index;
+				batch.Last = index;
+			}
+
+			void Clear()
+			{
+				Draws.clear();
+				Batches.clear();
+			}
+
+		private:
+			static constexpr size_t MaxLookback = 32;
+
+			bool Overlaps(const Batch& batch, const SDL_Rect& destination) const
+			{
+				if (!SDL_HasIntersection(&batch.Bounds, &destination)) return false;
+				for (Uint32 index = batch.First; index != None; index = Draws[index].Next)
+				{
+					if (SDL_HasIntersection(&Draws[index].Destination, &destination)) return true;
+				}
+				return false;
+			}
+
+			std::vector<Draw> Draws;
+			std::vector<Batch> Batches;
+		};
+
+		struct Device
+		{
+			SDL_Renderer* Renderer;
+			// Set by the event watch, which SDL may call from any thread.
+			std::atomic<bool> CacheWasInvalidated{ false };
+
+			ImGuiSDL::Options Options;
+			ImGuiSDL::Stats Stats;
+			// Counts the calls it makes to SDL in the stats, so it has to come after them.
+			RenderState State;
+			// The frame times and triangle cache hit rates of the most recent frames for the stats window, oldest first starting at HistoryOffset.
+			std::array<float, 120> TimeHistory = {};
+			std::array<float, 120> HitRateHistory = {};
+			int HistoryOffset = 0;
+			// Whether SDL_RenderGeometry is available in both the SDL headers this was built with and the SDL library that was actually loaded.
+			bool RenderGeometrySupported = false;
+
+			struct ClipRect
+			{
+				int X, Y, Width, Height;
+			} Clip;
+
+			// Textures of evicted triangles are recycled through the pool. It has to outlive the atlases and the triangle cache, which release into it.
+			TexturePool Textures;
+			TextureAtlas TargetAtlas;
+			TextureAtlas StreamingAtlas;
+
+			// The font texture, and a copy of its pixels that the CPU rasterizer samples from. Untextured triangles sample the white pixel of the
+			// font. The font texture belongs to the device unless it was created for replaying a capture. Draw commands refer to the font with
+			// the address of FontTextureSentinel, which every device swaps for its own font texture.
+			SDL_Texture* FontTexture = nullptr;
+			bool OwnsFontTexture = false;
+			PixelSource FontPixels;
+			ImVec2 WhitePixel;
+
+			// Reused for every triangle that is rasterized on the CPU, so that cache misses don't allocate.
+			std::vector<ImU32> RasterBuffer;
+			// The vertices of the run of triangles that is drawn, moved relative to its cache item, and its indices moved to its first vertex.
+			std::vector<ImDrawVert> RunVertices;
+			std::vector<ImDrawIdx> RunIndices;
+
+			// Frames that are rasterized by the CPU as a whole are uploaded into the frame texture, and then blended onto the render target.
+			FrameRasterizer Frame;
+			SDL_Texture* FrameTexture = nullptr;
+			std::unique_ptr<WorkerPool> Workers;
+
+			// With damage tracking, everything is drawn into the composite texture, which keeps its contents between frames. Only the damaged areas
+			// of it are drawn again.
+			DamageTracker Damage;
+			SDL_Texture* CompositeTexture = nullptr;
+			std::vector<SDL_Rect> DrawAreas;
+
+			// A copy of the draw data in pixels of whatever is drawn into, which is only made when the framebuffer scale or the render scale isn't one
+			// and SDL can't scale it instead, or when the draw data doesn't start at the origin. Its buffers are reused from frame to frame.
+			std::vector<std::unique_ptr<ImDrawList>> ScaledLists;
+			std::vector<ImDrawList*> ScaledListPointers;
+			ImDrawData ScaledDrawData;
+
+			// Whole draw lists that were rendered into textures of their own.
+			DrawListCache ListCache;
+
+			struct TriangleCacheItem
+			{
+				// Most triangles live in a region of a shared atlas page, only triangles that are too large for the atlas own their texture.
+				TextureAtlas* Atlas = nullptr;
+				TextureAtlas::Region Region;
+				TexturePool* Pool = nullptr;
+
+				SDL_Texture* Texture = nullptr;
+				SDL_Rect Source = { 0, 0, 0, 0 };
+				int Width = 0, Height = 0;
+				// The color and alpha mod of a texture the item owns, shared textures keep track of it in their atlas page.
+				ImU32 Tint = 0xffffffff;
+				// The texels of the triangle, which is what counts against the budget of the triangle cache.
+				size_t Bytes = 0;
+				// The texture the triangle samples, if any, and where its key is in the list of that texture in TextureIndex.
+				SDL_Texture* SampledTexture = nullptr;
+				size_t IndexSlot = 0;
+
+				~TriangleCacheItem()
+				{
+					if (Atlas) Atlas->Free(Region);
+					else if (Texture) Pool->Release(Texture);
+				}
+			};
+
+			// The triangle cache has to be basically a full representation of the triangle.
+			// This includes the (offset) vertex positions, texture coordinates and vertex colors.
+			struct TriangleVertexKey
+			{
+				float X, Y, U, V;
+				ImU32 Color;
+			};
+
+			// Hashed and compared as raw bytes, so there must not be any padding in here. Convex polygons are cached as a whole, those are keyed by
+			// their first three vertices along with their number of points and a hash of all of their vertices. Single triangles have zero points.
+			// Items that were cut off at their clip rect have their size in the key, all others have a size of zero (see GetVisibleBounds). The
+			// corner sprites of rounded rectangles share the cache, they have CornerSpritePoints and their radius and corner in the hash.
+			struct TriangleKey
+			{
+				SDL_Texture* Texture;
+				TriangleVertexKey Vertices[3];
+				Uint32 Points;
+				Uint32 Hash[2];
+				Uint32 Size[2];
+
+				bool operator==(const TriangleKey& other) const { return std::memcmp(this, &other, sizeof(TriangleKey)) == 0; }
+			};
+			static_assert(sizeof(TriangleKey) == sizeof(SDL_Texture*) + 3 * sizeof(TriangleVertexKey) + 5 * sizeof(Uint32), "TriangleKey must not be padded");
+			static const Uint32 CornerSpritePoints = 0xffffffff;
+
+			LRUCache<TriangleKey, std::unique_ptr<TriangleCacheItem>> TriangleCache;
+			size_t TriangleCacheBytes = 0;
+			// The cached triangles that were too large for the atlas and have a texture of their own, and the memory used by those textures.
+			size_t OwnedCacheTextures = 0;
+			size_t OwnedCacheBytes = 0;
+			// The keys of the cached triangles that sample a texture, by texture, so that only those are dropped when the texture changes.
+			std::map<SDL_Texture*, std::vector<TriangleKey>> TextureIndex;
+
+			// Solid rectangles are collected here while they share a color, and are then sent to the renderer with a single SDL_RenderFillRects call.
+			std::vector<SDL_Rect> RectBatch;
+			ImU32 RectBatchColor = 0;
+
+			// Textured quads and cached triangles are collected while they share a texture and a color, so that the texture mods only have to be set once
+			// for all of them. Cache textures keep track of their tint themselves (see CopyCacheItem), all other textures through the render state.
+			struct QuadCopy
+			{
+				SDL_Rect Source, Destination;
+				SDL_RendererFlip Flip;
+			};
+
+			std::vector<QuadCopy> QuadBatch;
+			SDL_Texture* QuadBatchTexture = nullptr;
+			ImU32* QuadBatchTint = nullptr;
+			ImU32 QuadBatchColor = 0;
+
+			// With ReorderDraws, fills and copies are queued instead of batched, and the queue is drawn wherever the batches would be flushed.
+			DrawQueue Queue;
+			std::vector<SDL_Rect> QueuedRects;
+			// The texture and color of the most recent fills or copies, to count the batches in the stats. Fills have no texture.
+			SDL_Texture* LastBatchTexture = nullptr;
+			ImU32 LastBatchColor = 0;
+
+			// Frames that were submitted with Submit instead of Render. Its worker reads the font pixels, so it has to be stopped before anything else
+			// is destroyed.
+			AsyncRenderer Async;
+
+			Device(SDL_Renderer* renderer)
+				: Renderer(renderer),
+				  State(renderer, Stats.SDLCalls),
+				  Textures(renderer),
+				  TargetAtlas(renderer, Textures, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET),
+				  StreamingAtlas(renderer, Textures, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING)
+			{
+#if IMGUI_SDL_HAS_RENDER_GEOMETRY
+				SDL_version linked;
+				SDL_GetVersion(&linked);
+				RenderGeometrySupported = SDL_VERSIONNUM(linked.major, linked.minor, linked.patch) >= SDL_VERSIONNUM(2, 0, 18);
+#endif
+			}
+
+			~Device()
+			{
+				if (OwnsFontTexture) SDL_DestroyTexture(FontTexture);
+				if (FrameTexture) SDL_DestroyTexture(FrameTexture);
+				if (CompositeTexture) SDL_DestroyTexture(CompositeTexture);
+			}
+
+			bool UsesRenderGeometry() const { return RenderGeometrySupported && Options.UseRenderGeometry; }
+
+			// Submits all triangles of a draw command with one call. Returns false if the renderer refused the geometry, in which case the caller has to
+			// fall back to the software rasterizer.
+			bool DrawGeometry(const ImDrawVert* vertices, int vertexCount, const ImDrawIdx* indices, int indexCount, SDL_Texture* texture)
+			{
+#if IMGUI_SDL_HAS_RENDER_GEOMETRY
+#if SDL_VERSION_ATLEAST(2, 0, 19)
+				const SDL_Color* colors = reinterpret_cast<const SDL_Color*>(&vertices->col);
+#else
+				const int* colors = reinterpret_cast<const int*>(&vertices->col);
+#endif
+				ScopedTimer timer(Stats.CopyTime);
+				if (texture) State.ResetTextureMods(texture);
+				Stats.SDLCalls++;
+
+				const int stride = static_cast<int>(sizeof(ImDrawVert));
+				const int result = SDL_RenderGeometryRaw(Renderer, texture,
+					&vertices->pos.x, stride, colors, stride, &vertices->uv.x, stride, vertexCount,
+					indices, indexCount, static_cast<int>(sizeof(ImDrawIdx)));
+				if (result == 0) return true;
+
+				// Some renderers don't implement geometry rendering, those keep using the software rasterizer from now on.
+				RenderGeometrySupported = false;
+#endif
+				return false;
+			}
+
+			void SetClipRect(const ClipRect& rect)
+			{
+				Clip = rect;
+				const SDL_Rect clip = { rect.X, rect.Y, rect.Width, rect.Height };
+				State.SetClipRect(&clip);
+			}
+
+			void EnableClip() { SetClipRect(Clip); }
+
+			void DisableClip() { State.SetClipRect(nullptr); }
+
+			// Reuses a released texture of the same size if there is one. Those keep their old contents, so the caller has to overwrite them.
+			SDL_Texture* MakeTexture(int width, int height, Uint32 format = SDL_PIXELFORMAT_RGBA32, SDL_TextureAccess access = SDL_TEXTUREACCESS_TARGET)
+			{
+				return Textures.Acquire(width, height, format, access);
+			}
+
+			// Triangles can be rasterized on the CPU if they are untextured or use the font texture, since that's the only one there's a CPU copy of.
+			bool CanRasterizeOnCPU(SDL_Texture* texture) const
+			{
+				return Options.RasterizeOnCPU && (!texture || texture == FontTexture);
+			}
+
+			// Finds room for the triangle of the cache item, which has to have its size set already. Items that are filled by the CPU rasterizer
+			// go into streaming textures, items that are drawn to by SDL go into render targets. Items that are too large for the atlas get a texture
+			// rounded up to its size class, so that it can be recycled for other large triangles once the item is evicted.
+			void AllocateCacheItem(TriangleCacheItem& item, bool rasterizeOnCPU)
+			{
+				item.Bytes = static_cast<size_t>(item.Width) * item.Height * sizeof(ImU32);
+
+				TextureAtlas& atlas = rasterizeOnCPU ? StreamingAtlas : TargetAtlas;
+				if (atlas.Allocate(item.Width, item.Height, item.Region))
+				{
+					item.Atlas = &atlas;
+					item.Texture = atlas.GetTexture(item.Region);
+					item.Source = item.Region.Rect;
+				}
+				else
+				{
+					const int width = TexturePool::GetSizeClass(item.Width), height = TexturePool::GetSizeClass(item.Height);
+					item.Pool = &Textures;
+					item.Texture = rasterizeOnCPU
+						? MakeTexture(width, height, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING)
+						: MakeTexture(width, height);
+					item.Source = { 0, 0, item.Width, item.Height };
+				}
+			}
+
+			static size_t GetOwnedTextureBytes(const TriangleCacheItem& item)
+			{
+				return static_cast<size_t>(TexturePool::GetSizeClass(item.Width)) * TexturePool::GetSizeClass(item.Height) * sizeof(ImU32);
+			}
+
+			void InsertCacheItem(const TriangleKey& key, std::unique_ptr<TriangleCacheItem> item)
+			{
+				TriangleCacheBytes += item->Bytes;
+				if (!item->Atlas)
+				{
+					OwnedCacheTextures++;
+					OwnedCacheBytes += GetOwnedTextureBytes(*item);
+				}
+				if (key.Texture)
+				{
+					std::vector<TriangleKey>& keys = TextureIndex[key.Texture];
+					item->SampledTexture = key.Texture;
+					item->IndexSlot = keys.size();
+					keys.push_back(key);
+				}
+				TriangleCache.Insert(key, std::move(item));
+			}
+
+			// Takes an item that was removed from the triangle cache off the books. The last key of its texture's list moves into its slot.
+			void ForgetCacheItem(const TriangleCacheItem& item)
+			{
+				TriangleCacheBytes -= item.Bytes;
+				if (!item.Atlas)
+				{
+					OwnedCacheTextures--;
+					OwnedCacheBytes -= GetOwnedTextureBytes(item);
+				}
+				if (item.SampledTexture)
+				{
+					std::vector<TriangleKey>& keys = TextureIndex[item.SampledTexture];
+					keys[item.IndexSlot] = keys.back();
+					keys.pop_back();
+					if (item.IndexSlot < keys.size()) (*TriangleCache.Peek(keys[item.IndexSlot]))->IndexSlot = item.IndexSlot;
+				}
+			}
+
+			// Evicts the least recently used triangles until the cache fits into its budget again. Their textures go back into the pool.
+			void TrimTriangleCache()
+			{
+				while (TriangleCacheBytes > Options.TriangleCacheSize)
+				{
+					std::unique_ptr<TriangleCacheItem> evicted = TriangleCache.EvictLeastRecent();
+					if (!evicted) break;
+					ForgetCacheItem(*evicted);
+					Stats.TriangleCacheEvictions++;
+				}
+			}
+
+			// Drops the cached triangles that sample the texture, after its contents changed. All other triangles stay cached.
+			void InvalidateTexture(SDL_Texture* texture)
+			{
+				auto found = TextureIndex.find(texture);
+				if (found == TextureIndex.end()) return;
+
+				const std::vector<TriangleKey> keys = std::move(found->second);
+				TextureIndex.erase(found);
+				for (const TriangleKey& key : keys)
+				{
+					std::unique_ptr<TriangleCacheItem> item = TriangleCache.Take(key);
+					item->SampledTexture = nullptr;
+					ForgetCacheItem(*item);
+				}
+			}
+
+			// Counts the textures that are kept around by the caches and the texture pool, and roughly how much memory they use.
+			void CountCachedTextures()
+			{
+				Stats.CachedTriangles = TriangleCache.GetSize();
+				Stats.CachedTextures = TargetAtlas.GetPageCount() + StreamingAtlas.GetPageCount() + OwnedCacheTextures + ListCache.GetCount() + Textures.GetCount();
+				Stats.CachedTextureBytes = TargetAtlas.GetBytes() + StreamingAtlas.GetBytes() + ListCache.GetBytes() + Textures.GetBytes();
+				Stats.CachedTextureBytes += OwnedCacheBytes;
+			}
+
+			// Adds the frame that was just rendered to the history of the stats window.
+			void RecordHistory()
+			{
+				const size_t lookups = Stats.TriangleCacheHits + Stats.TriangleCacheMisses;
+				TimeHistory[HistoryOffset] = static_cast<float>(Stats.TotalTime);
+				HitRateHistory[HistoryOffset] = lookups > 0 ? static_cast<float>(Stats.TriangleCacheHits) / lookups * 100.0f : 100.0f;
+				HistoryOffset = (HistoryOffset + 1) % static_cast<int>(TimeHistory.size());
+			}
+
+			void ResetTriangleCache()
+			{
+				TriangleCache.Reset();
+				TriangleCacheBytes = 0;
+				OwnedCacheTextures = OwnedCacheBytes = 0;
+				TextureIndex.clear();
+			}
+
+			// Copies a region of the font atlas into the pixels that the CPU rasterizer samples from. The atlas pixels are four bytes each, in RGBA order.
+			void CopyFontPixels(const unsigned char* pixels, const SDL_Rect& region)
+			{
+				for (int y = region.y; y < region.y + region.h; y++)
+				{
+					for (int x = region.x; x < region.x + region.w; x++)
+					{
+						const size_t index = static_cast<size_t>(y) * FontPixels.Width + x;
+						const unsigned char* pixel = pixels + index * 4;
+						FontPixels.Pixels[index] = PackColor(pixel[0], pixel[1], pixel[2], pixel[3]);
+					}
+				}
+			}
+
+			// Rasterizes a triangle into a CPU buffer and uploads it into the texture region of the cache item with one call. The vertices have to be
+			// relative to the top left corner of the item.
+			void RasterizeCacheItem(const TriangleCacheItem& item, const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2, SDL_Texture* texture)
+			{
+				RasterBuffer.assign(static_cast<size_t>(item.Width) * item.Height, 0);
+				const PixelBuffer buffer = { RasterBuffer.data(), item.Width, item.Height, item.Width };
+				Stats.PixelsRasterized += RasterizeTriangle(v0, v1, v2, texture ? &FontPixels : nullptr, buffer);
+
+				SDL_UpdateTexture(item.Texture, &item.Source, RasterBuffer.data(), item.Width * static_cast<int>(sizeof(ImU32)));
+				Stats.SDLCalls++;
+			}
+
+			// Rasterizes a convex polygon into a CPU buffer and uploads it into the cache item with one call. The vertices are laid out the way ImGui
+			// fills polygons (see GetConvexFan), relative to the top left corner of the item. Single colored polygons are filled a scanline at a time,
+			// only the triangles of an antialiased fringe are rasterized one by one.
+			void RasterizeFanItem(const TriangleCacheItem& item, const std::vector<ImDrawVert>& vertices, unsigned int points, bool antialiased, SDL_Texture* texture)
+			{
+				RasterBuffer.assign(static_cast<size_t>(item.Width) * item.Height, 0);
+				const PixelBuffer buffer = { RasterBuffer.data(), item.Width, item.Height, item.Width };
+				const PixelSource* source = texture ? &FontPixels : nullptr;
+				const unsigned int stride = antialiased ? 2 : 1;
+
+				bool isUniformColor = !texture;
+				for (unsigned int i = 1; i < points && isUniformColor; i++) isUniformColor = vertices[i * stride].col == vertices[0].col;
+
+				size_t pixels = 0;
+				if (isUniformColor) pixels += FillConvexPolygon(vertices.data(), points, stride, vertices[0].col, buffer);
+				else
+				{
+					for (unsigned int i = 2; i < points; i++) pixels += RasterizeTriangle(vertices[0], vertices[(i - 1) * stride], vertices[i * stride], source, buffer);
+				}
+
+				if (antialiased)
+				{
+					for (unsigned int i0 = points - 1, i1 = 0; i1 < points; i0 = i1++)
+					{
+						const ImDrawVert& inner0 = vertices[i0 * 2], &outer0 = vertices[i0 * 2 + 1];
+						const ImDrawVert& inner1 = vertices[i1 * 2], &outer1 = vertices[i1 * 2 + 1];
+						pixels += RasterizeTriangle(inner1, inner0, outer0, source, buffer);
+						pixels += RasterizeTriangle(outer0, outer1, inner1, source, buffer);
+					}
+				}
+				Stats.PixelsRasterized += pixels;
+
+				SDL_UpdateTexture(item.Texture, &item.Source, RasterBuffer.data(), item.Width * static_cast<int>(sizeof(ImU32)));
+				Stats.SDLCalls++;
+			}
+
+			// Rasterizes a run of triangles that isn't a fan into a CPU buffer and uploads it into the cache item with one call. The vertices are
+			// relative to the top left corner of the item, and the indices to the first vertex. Where triangles of the run overlap, like at the sharp
+			// joints of a line, the later one replaces the earlier one instead of being blended over it.
+			void RasterizeRunItem(const TriangleCacheItem& item, const std::vector<ImDrawVert>& vertices, const std::vector<ImDrawIdx>& indices, SDL_Texture* texture)
+			{
+				RasterBuffer.assign(static_cast<size_t>(item.Width) * item.Height, 0);
+				const PixelBuffer buffer = { RasterBuffer.data(), item.Width, item.Height, item.Width };
+				const PixelSource* source = texture ? &FontPixels : nullptr;
+
+				for (size_t i = 0; i + 3 <= indices.size(); i += 3)
+				{
+					Stats.PixelsRasterized += RasterizeTriangle(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], source, buffer);
+				}
+
+				SDL_UpdateTexture(item.Texture, &item.Source, RasterBuffer.data(), item.Width * static_cast<int>(sizeof(ImU32)));
+				Stats.SDLCalls++;
+			}
+
+			// Rasterizes a triangle into the texture region of the cache item. The vertices have to be relative to the top left corner of the item.
+			void RenderCacheItem(const TriangleCacheItem& item, const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2, SDL_Texture* texture, SDL_Texture* target)
+			{
+				// The blend mode isn't set back afterwards, everything that draws onto the render target sets the one it needs, so that a run of
+				// cache misses doesn't switch it back and forth.
+				State.SetTarget(item.Texture);
+				State.SetBlendMode(SDL_BLENDMODE_NONE);
+
+				// The region has to be cleared, and nothing may be drawn outside of it since its neighbours are in use by other triangles.
+				State.SetClipRect(&item.Source);
+				State.SetDrawColor(0);
+				SDL_RenderFillRect(Renderer, &item.Source);
+				Stats.SDLCalls++;
+
+				Stats.PixelsRasterized += DrawTriangle(State, Stats, v0, v1, v2, texture, SDL_Point{ item.Source.x, item.Source.y }, SDL_Rect{ 0, 0, item.Width, item.Height });
+
+				State.SetTarget(target);
+				EnableClip();
+			}
+
+			// Draws a cached triangle, tinted with the given color. It's batched with the quads, so consecutive triangles from the same atlas page take
+			// a single batch. The texture mods are only changed if the texture was last drawn with a different tint.
+			void CopyCacheItem(TriangleCacheItem& item, const SDL_Rect& destination, ImU32 tint)
+			{
+				ImU32& textureTint = item.Atlas ? item.Region.Owner->Tint : item.Tint;
+				BatchQuad(item.Texture, &textureTint, item.Source, destination, SDL_FLIP_NONE, tint);
+			}
+
+			void SetCacheTint(SDL_Texture* texture, ImU32& textureTint, ImU32 tint)
+			{
+				if (textureTint == tint) return;
+				SDL_SetTextureColorMod(texture, (tint >> 0) & 0xff, (tint >> 8) & 0xff, (tint >> 16) & 0xff);
+				SDL_SetTextureAlphaMod(texture, (tint >> 24) & 0xff);
+				textureTint = tint;
+				Stats.SDLCalls += 2;
+			}
+
+			// The corners of rounded rectangles are copied from sprites that hold the coverage of a quarter circle in their alpha channel. They're
+			// white and tinted with the color of the rectangle, so there's only one sprite per radius and corner, and they always live in the atlas.
+			// They're kept in the triangle cache, so they count against its budget and are evicted like everything else in it. The cache is only
+			// trimmed at the end of a frame, so a sprite stays valid until then.
+			enum Corner { TopLeft, TopRight, BottomRight, BottomLeft };
+
+			TriangleCacheItem* GetCornerSprite(float radius, int corner, bool antialiased)
+			{
+				// Radii are snapped to sixteenths of a pixel, the same as the positions of the rasterizer.
+				const Uint32 steps = static_cast<Uint32>(SDL_floor(radius * 16.0f + 0.5f));
+				TriangleKey key = {};
+				key.Points = CornerSpritePoints;
+				key.Hash[0] = (steps << 3) | (static_cast<Uint32>(corner) << 1) | (antialiased ? 1 : 0);
+				if (const auto* found = TriangleCache.TryGet(key))
+				{
+					Stats.TriangleCacheHits++;
+					return found->get();
+				}
+
+				const float r = steps / 16.0f;
+				const int size = static_cast<int>(SDL_ceil(r));
+				auto item = std::make_unique<TriangleCacheItem>();
+				item->Width = item->Height = size;
+				if (size <= 0 || size > StreamingAtlas.GetMaxRegionSize() || !StreamingAtlas.Allocate(size, size, item->Region)) return nullptr;
+				item->Atlas = &StreamingAtlas;
+				item->Texture = StreamingAtlas.GetTexture(item->Region);
+				item->Source = item->Region.Rect;
+				item->Bytes = static_cast<size_t>(size) * size * sizeof(ImU32);
+
+				// The coverage falls off over one pixel centered on the outline, which is what the fringe of ImGui's antialiased fills looks like.
+				// Without antialiasing, pixels are covered if their center is inside, the same as for triangles.
+				ScopedTimer timer(Stats.RasterizationTime), fillTimer(Stats.CacheFillTime);
+				RasterBuffer.resize(static_cast<size_t>(size) * size);
+				for (int y = 0; y < size; y++)
+				{
+					for (int x = 0; x < size; x++)
+					{
+						// The distance from the pixel center to the corner of the inner rectangle, mirrored so that every corner is a top left one.
+						const float px = (corner == TopLeft || corner == BottomLeft) ? x + 0.5f : size - x - 0.5f;
+						const float py = (corner == TopLeft || corner == TopRight) ? y + 0.5f : size - y - 0.5f;
+						const float dx = std::max(r - px, 0.0f), dy = std::max(r - py, 0.0f);
+						const float distance = std::sqrt(dx * dx + dy * dy);
+						const float coverage = antialiased ? std::min(std::max(r - distance + 0.5f, 0.0f), 1.0f) : (distance <= r ? 1.0f : 0.0f);
+						RasterBuffer[static_cast<size_t>(y) * size + x] = PackColor(255, 255, 255, static_cast<Uint8>(coverage * 255.0f + 0.5f));
+					}
+				}
+				SDL_UpdateTexture(item->Texture, &item->Source, RasterBuffer.data(), size * static_cast<int>(sizeof(ImU32)));
+				Stats.PixelsRasterized += static_cast<size_t>(size) * size;
+				Stats.TriangleCacheMisses++;
+				Stats.SDLCalls++;
+
+				TriangleCacheItem* sprite = item.get();
+				InsertCacheItem(key, std::move(item));
+				return sprite;
+			}
+
+			// Fills a rectangle on whole pixels whose corners are rounded with the given radii, in the order of the Corner enum. The corners are copied
+			// from sprites and everything in between is filled with rectangles. Returns false if a corner doesn't fit into the atlas.
+			bool FillRoundedRect(const SDL_Rect& rect, const float (&radii)[4], ImU32 color, bool antialiased)
+			{
+				TriangleCacheItem* sprites[4] = {};
+				int sizes[4] = {};
+				for (int corner = 0; corner < 4; corner++)
+				{
+					if (radii[corner] <= 0.0f) continue;
+					sprites[corner] = GetCornerSprite(radii[corner], corner, antialiased);
+					if (!sprites[corner]) return false;
+					sizes[corner] = sprites[corner]->Width;
+				}
+
+				// The rectangles of this shape can be batched further after its corners are drawn, since they don't overlap them.
+				const SDL_Rect boxes[4] = {
+					{ rect.x, rect.y, sizes[TopLeft], sizes[TopLeft] },
+					{ rect.x + rect.w - sizes[TopRight], rect.y, sizes[TopRight], sizes[TopRight] },
+					{ rect.x + rect.w - sizes[BottomRight], rect.y + rect.h - sizes[BottomRight], sizes[BottomRight], sizes[BottomRight] },
+					{ rect.x, rect.y + rect.h - sizes[BottomLeft], sizes[BottomLeft], sizes[BottomLeft] }
+				};
+				for (int corner = 0; corner < 4; corner++)
+				{
+					if (sprites[corner]) CopyCacheItem(*sprites[corner], boxes[corner], color);
+				}
+
+				// The top and bottom bands are as high as their larger corner, the smaller corner leaves a gap below or above it.
+				const int top = std::max(sizes[TopLeft], sizes[TopRight]), bottom = std::max(sizes[BottomLeft], sizes[BottomRight]);
+				const SDL_Rect fills[] = {
+					{ rect.x + sizes[TopLeft], rect.y, rect.w - sizes[TopLeft] - sizes[TopRight], top },
+					{ rect.x, rect.y + sizes[TopLeft], sizes[TopLeft], top - sizes[TopLeft] },
+					{ rect.x + rect.w - sizes[TopRight], rect.y + sizes[TopRight], sizes[TopRight], top - sizes[TopRight] },
+					{ rect.x, rect.y + top, rect.w, rect.h - top - bottom },
+					{ rect.x + sizes[BottomLeft], rect.y + rect.h - bottom, rect.w - sizes[BottomLeft] - sizes[BottomRight], bottom },
+					{ rect.x, rect.y + rect.h - bottom, sizes[BottomLeft], bottom - sizes[BottomLeft] },
+					{ rect.x + rect.w - sizes[BottomRight], rect.y + rect.h - bottom, sizes[BottomRight], bottom - sizes[BottomRight] }
+				};
+				for (const SDL_Rect& fill : fills)
+				{
+					if (fill.w > 0 && fill.h > 0) FillRect(fill, color);
+				}
+				return true;
+			}
+
+			bool UsesFrameRasterizer() const { return Options.RasterizeFrames; }
+
+			// The frame rasterizer has the same limitation as the CPU rasterizer for cache misses, it only knows the pixels of the font texture.
+			bool CanRasterizeFrame(SDL_Texture* texture) const
+			{
+				return !texture || texture == FontTexture;
+			}
+
+			void GetTargetSize(SDL_Texture* target, int& width, int& height) const
+			{
+				width = height = 0;
+				if (target) SDL_QueryTexture(target, nullptr, nullptr, &width, &height);
+				else SDL_GetRendererOutputSize(Renderer, &width, &height);
+			}
+
+			WorkerPool& GetWorkers()
+			{
+				const int threadCount = std::max(Options.RasterizerThreads > 0 ? Options.RasterizerThreads : SDL_GetCPUCount(), 1);
+				if (!Workers || Workers->GetThreadCount() != threadCount) Workers = std::make_unique<WorkerPool>(threadCount);
+				return *Workers;
+			}
+
+			// Rasterizes everything the frame rasterizer collected so far and blends it onto the render target with a single copy. Has to be called
+			// before anything is drawn in a different way, so that the rasterized primitives keep their place in the draw order.
+			void FlushFrame()
+			{
+				if (Frame.IsEmpty()) return;
+
+				SDL_Rect area;
+				{
+					ScopedTimer timer(Stats.RasterizationTime);
+					area = Frame.Rasterize(GetWorkers());
+					Stats.PixelsRasterized += Frame.GetRasterizedPixels();
+				}
+
+				CopyFrame(Frame, area);
+				Frame.Begin(Frame.GetWidth(), Frame.GetHeight());
+			}
+
+			// Uploads the area of a rasterized frame into the frame texture, and blends it onto the render target.
+			void CopyFrame(const FrameRasterizer& frame, const SDL_Rect& area)
+			{
+				if (SDL_RectEmpty(&area)) return;
+
+				ScopedTimer timer(Stats.CopyTime);
+				int textureWidth = 0, textureHeight = 0;
+				if (FrameTexture) SDL_QueryTexture(FrameTexture, nullptr, nullptr, &textureWidth, &textureHeight);
+				if (textureWidth != frame.GetWidth() || textureHeight != frame.GetHeight())
+				{
+					if (FrameTexture) SDL_DestroyTexture(FrameTexture);
+					FrameTexture = MakeTexture(frame.GetWidth(), frame.GetHeight(), SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING);
+				}
+
+				const int pitch = frame.GetWidth() * static_cast<int>(sizeof(ImU32));
+				SDL_UpdateTexture(FrameTexture, &area, frame.GetPixels() + area.y * frame.GetWidth() + area.x, pitch);
+
+				DisableClip();
+				SDL_RenderCopy(Renderer, FrameTexture, &area, &area);
+				Stats.SDLCalls += 2;
+				EnableClip();
+			}
+
+			// Makes a render target for drawing a whole layer of ImGui into, which is then blended onto the actual render target with a single copy.
+			// Everything is blended onto a transparent background, so the texture ends up with premultiplied alpha.
+			SDL_Texture* MakeLayerTexture(int width, int height)
+			{
+				SDL_Texture* texture = MakeTexture(width, height);
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+				const SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+					SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+					SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+				if (texture && SDL_SetTextureBlendMode(texture, premultiplied) != 0)
+#endif
+				{
+					// Renderers without custom blend modes blend it as straight alpha, which makes translucent parts a bit darker.
+					SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+				}
+				return texture;
+			}
+
+			// Makes sure the composite texture exists and has the given size. Returns false if it had to be created, in which case it has no contents yet.
+			bool PrepareComposite(int width, int height)
+			{
+				int textureWidth = 0, textureHeight = 0;
+				if (CompositeTexture) SDL_QueryTexture(CompositeTexture, nullptr, nullptr, &textureWidth, &textureHeight);
+				if (CompositeTexture && textureWidth == width && textureHeight == height) return true;
+
+				ReleaseComposite();
+				CompositeTexture = MakeLayerTexture(width, height);
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+				// With a RenderScale, the composite texture is stretched onto the render target.
+				if (CompositeTexture) SDL_SetTextureScaleMode(CompositeTexture, SDL_ScaleModeLinear);
+#endif
+				return false;
+			}
+
+			// Returns the draw data with its positions and clip rects relative to its DisplayPos and multiplied by the scale, or the draw data itself if
+			// that doesn't change anything. The copy is only valid until the next call, and callbacks get the copied draw lists.
+			ImDrawData* ScaleDrawData(ImDrawData* drawData, const ImVec2& scale)
+			{
+				const ImVec2 origin = drawData->DisplayPos;
+				if (origin.x == 0.0f && origin.y == 0.0f && scale.x == 1.0f && scale.y == 1.0f) return drawData;
+
+				while (ScaledLists.size() < static_cast<size_t>(drawData->CmdListsCount)) ScaledLists.push_back(std::make_unique<ImDrawList>(nullptr));
+				ScaledListPointers.clear();
+				for (int n = 0; n < drawData->CmdListsCount; n++)
+				{
+					CopyDrawList(*drawData->CmdLists[n], *ScaledLists[n], origin, scale);
+					ScaledListPointers.push_back(ScaledLists[n].get());
+				}
+
+				ScaledDrawData.Valid = drawData->Valid;
+				ScaledDrawData.CmdListsCount = drawData->CmdListsCount;
+#if IMGUI_VERSION_NUM >= 18980
+				ScaledDrawData.CmdLists.resize(0);
+				for (ImDrawList* list : ScaledListPointers) ScaledDrawData.CmdLists.push_back(list);
+#else
+				ScaledDrawData.CmdLists = ScaledListPointers.data();
+#endif
+				ScaledDrawData.TotalVtxCount = drawData->TotalVtxCount;
+				ScaledDrawData.TotalIdxCount = drawData->TotalIdxCount;
+				ScaledDrawData.DisplayPos = ImVec2(0.0f, 0.0f);
+				ScaledDrawData.DisplaySize = ImVec2(drawData->DisplaySize.x * scale.x, drawData->DisplaySize.y * scale.y);
+				ScaledDrawData.FramebufferScale = ImVec2(1.0f, 1.0f);
+				return &ScaledDrawData;
+			}
+
+			void ReleaseComposite()
+			{
+				if (CompositeTexture) SDL_DestroyTexture(CompositeTexture);
+				CompositeTexture = nullptr;
+				Damage.Invalidate();
+			}
+
+			// Clears the areas of the current render target that are about to be drawn again.
+			void ClearAreas(const std::vector<SDL_Rect>& areas)
+			{
+				State.SetBlendMode(SDL_BLENDMODE_NONE);
+				State.SetDrawColor(0);
+				DisableClip();
+				SDL_RenderFillRects(Renderer, areas.data(), static_cast<int>(areas.size()));
+				Stats.SDLCalls++;
+			}
+
+			void FillRect(const SDL_Rect& rect, ImU32 color)
+			{
+				if (Options.ReorderDraws)
+				{
+					Queue.Add(nullptr, color, nullptr, rect, rect, SDL_FLIP_NONE);
+					return;
+				}
+
+				FlushQuads();
+				if (!RectBatch.empty() && color != RectBatchColor) FlushRects();
+
+				RectBatchColor = color;
+				RectBatch.push_back(rect);
+			}
+
+			// Has to be called before anything else is drawn, so that the batched rectangles keep their place in the draw order.
+			void FlushRects()
+			{
+				if (RectBatch.empty()) return;
+
+				ScopedTimer timer(Stats.CopyTime);
+				State.SetBlendMode(SDL_BLENDMODE_BLEND);
+				State.SetDrawColor(RectBatchColor);
+				SDL_RenderFillRects(Renderer, RectBatch.data(), static_cast<int>(RectBatch.size()));
+				CountBatch(nullptr, RectBatchColor);
+				Stats.SDLCalls++;
+				RectBatch.clear();
+			}
+
+			void CopyQuad(SDL_Texture* texture, const SDL_Rect& source, const SDL_Rect& destination, SDL_RendererFlip flip, ImU32 color)
+			{
+				BatchQuad(texture, nullptr, source, destination, flip, color);
+			}
+
+			void BatchQuad(SDL_Texture* texture, ImU32* tint, const SDL_Rect& source, const SDL_Rect& destination, SDL_RendererFlip flip, ImU32 color)
+			{
+				if (Options.ReorderDraws)
+				{
+					Queue.Add(texture, color, tint, source, destination, flip);
+					return;
+				}
+
+				FlushRects();
+				if (!QuadBatch.empty() && (texture != QuadBatchTexture || color != QuadBatchColor)) FlushQuads();
+
+				QuadBatchTexture = texture;
+				QuadBatchTint = tint;
+				QuadBatchColor = color;
+				QuadBatch.push_back(QuadCopy{ source, destination, flip });
+			}
+
+			// Same as with the rectangles, this has to be called before anything else is drawn.
+			void FlushQuads()
+			{
+				if (QuadBatch.empty()) return;
+
+				ScopedTimer timer(Stats.CopyTime);
+
+				// The texture mods are left as they are after the batch, the next batch of the same texture most likely uses the same color. They
+				// are restored at the end of the frame.
+				if (QuadBatchTint) SetCacheTint(QuadBatchTexture, *QuadBatchTint, QuadBatchColor);
+				else State.SetTextureMods(QuadBatchTexture, QuadBatchColor);
+				CountBatch(QuadBatchTexture, QuadBatchColor);
+
+				for (const QuadCopy& quad : QuadBatch)
+				{
+					if (quad.Flip == SDL_FLIP_NONE) SDL_RenderCopy(Renderer, QuadBatchTexture, &quad.Source, &quad.Destination);
+					else SDL_RenderCopyEx(Renderer, QuadBatchTexture, &quad.Source, &quad.Destination, 0.0, nullptr, quad.Flip);
+				}
+
+				Stats.SDLCalls += QuadBatch.size();
+				QuadBatch.clear();
+			}
+
+			// Draws the queue batch by batch. Fills of a batch take a single SDL_RenderFillRects call, the same as a batch without reordering.
+			void FlushQueue()
+			{
+				if (Queue.IsEmpty()) return;
+
+				ScopedTimer timer(Stats.CopyTime);
+				for (const DrawQueue::Batch& batch : Queue.GetBatches())
+				{
+					CountBatch(batch.Texture, batch.Color);
+					if (!batch.Texture)
+					{
+						QueuedRects.clear();
+						for (Uint32 index = batch.First; index != DrawQueue::None; index = Queue.GetDraw(index).Next) QueuedRects.push_back(Queue.GetDraw(index).Destination);
+
+						State.SetBlendMode(SDL_BLENDMODE_BLEND);
+						State.SetDrawColor(batch.Color);
+						SDL_RenderFillRects(Renderer, QueuedRects.data(), static_cast<int>(QueuedRects.size()));
+						Stats.SDLCalls++;
+						continue;
+					}
+
+					if (batch.Tint) SetCacheTint(batch.Texture, *batch.Tint, batch.Color);
+					else State.SetTextureMods(batch.Texture, batch.Color);
+
+					for (Uint32 index = batch.First; index != DrawQueue::None; index = Queue.GetDraw(index).Next)
+					{
+						const DrawQueue::Draw& draw = Queue.GetDraw(index);
+						if (draw.Flip == SDL_FLIP_NONE) SDL_RenderCopy(Renderer, batch.Texture, &draw.Source, &draw.Destination);
+						else SDL_RenderCopyEx(Renderer, batch.Texture, &draw.Source, &draw.Destination, 0.0, nullptr, draw.Flip);
+						Stats.SDLCalls++;
+					}
+				}
+				Queue.Clear();
+			}
+
+			void FlushBatches()
+			{
+				FlushRects();
+				FlushQuads();
+				FlushQueue();
+			}
+
+			// Counts a run of fills or copies in the stats, unless it continues the previous one.
+			void CountBatch(SDL_Texture* texture, ImU32 color)
+			{
+				if (Stats.DrawBatches > 0 && texture == LastBatchTexture && color == LastBatchColor) return;
+				LastBatchTexture = texture;
+				LastBatchColor = color;
+				Stats.DrawBatches++;
+			}
+
+			// Whether cache misses used up the time they may take per frame already, see TriangleCacheFillTime.
+			bool IsCacheFillOverBudget() const
+			{
+				return Options.TriangleCacheFillTime > 0.0 && Stats.CacheFillTime >= Options.TriangleCacheFillTime;
+			}
+
+			// Draws an untextured triangle that missed the cache after the budget ran out straight onto the render target, and leaves caching it to a
+			// later frame. A single colored triangle only takes an SDL call for every 1024 of its rows. Any other one is interpolated a pixel at a time,
+			// since flattening a gradient or an antialiased fringe to one color would draw an opaque band. Textured triangles aren't deferred.
+			void DrawDeferredTriangle(const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2, const SDL_Rect& clip)
+			{
+				FlushBatches();
+				State.SetBlendMode(SDL_BLENDMODE_BLEND);
+				Stats.PixelsRasterized += DrawTriangle(State, Stats, v0, v1, v2, nullptr, SDL_Point{ 0, 0 }, clip);
+				Stats.TrianglesDeferred++;
+			}
+
+			// Draws the triangles of a run that missed the cache after the budget ran out the same way, counted as a single deferred miss since it's
+			// cached as one item later.
+			void DrawDeferredRun(const ImDrawVert* vertexBuffer, const ImDrawIdx* indices, unsigned int indexCount, const SDL_Rect& clip)
+			{
+				FlushBatches();
+				State.SetBlendMode(SDL_BLENDMODE_BLEND);
+				for (unsigned int i = 0; i + 3 <= indexCount; i += 3)
+				{
+					Stats.PixelsRasterized += DrawTriangle(State, Stats, vertexBuffer[indices[i]], vertexBuffer[indices[i + 1]], vertexBuffer[indices[i + 2]], nullptr,
+						SDL_Point{ 0, 0 }, clip);
+				}
+				Stats.TrianglesDeferred++;
+			}
+
+			// Estimates how many more frames it takes until the deferred triangles are cached, at the average time a miss took in this frame.
+			void EstimateDegradedFrames()
+			{
+				if (Stats.TrianglesDeferred == 0 || Options.TriangleCacheFillTime <= 0.0) return;
+
+				const double missTime = Stats.TriangleCacheMisses > 0 ? Stats.CacheFillTime / Stats.TriangleCacheMisses : Options.TriangleCacheFillTime;
+				Stats.DegradedFrames = static_cast<size_t>(std::ceil(Stats.TrianglesDeferred * missTime / Options.TriangleCacheFillTime));
+			}
+		};
+
+		struct Rect
+		{
+			float MinX, MinY, MaxX, MaxY;
+			float MinU, MinV, MaxU, MaxV;
+
+			bool IsOnExtreme(const ImVec2& point) const
+			{
+				return (point.x == MinX || point.x == MaxX) && (point.y == MinY || point.y == MaxY);
+			}
+
+			bool UsesOnlyColor(const ImVec2& whitePixel) const
+			{
+				return MinU == MaxU && MinU == whitePixel.x && MinV == MaxV && MaxV == whitePixel.y;
+			}
+
+			static Rect CalculateBoundingBox(const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2)
+			{
+				return Rect{
+					std::min({ v0.pos.x, v1.pos.x, v2.pos.x }),
+					std::min({ v0.pos.y, v1.pos.y, v2.pos.y }),
+					std::max({ v0.pos.x, v1.pos.x, v2.pos.x }),
+					std::max({ v0.pos.y, v1.pos.y, v2.pos.y }),
+					std::min({ v0.uv.x, v1.uv.x, v2.uv.x }),
+					std::min({ v0.uv.y, v1.uv.y, v2.uv.y }),
+					std::max({ v0.uv.x, v1.uv.x, v2.uv.x }),
+					std::max({ v0.uv.y, v1.uv.y, v2.uv.y })
+				};
+			}
+		};
+
+		// ImGui emits most of its rectangles (window backgrounds, frames, separators, scrollbars, glyphs, images...) as two triangles (a, b, c) and (a, c, d)
+		// that share a diagonal. Returns false if the six indices don't form such a quad, or if it isn't axis aligned and uniformly colored. Otherwise the
+		// corners are returned in the order a, b, c, d, along with the bounding box of their positions and texture coordinates.
+		bool GetUniformQuad(const ImDrawVert* vertices, const ImDrawIdx* indices, const ImDrawVert* (&corners)[4], Rect& bounds)
+		{
+			if (indices[3] != indices[0] || indices[4] != indices[2]) return false;
+
+			const ImDrawVert& a = vertices[indices[0]];
+			const ImDrawVert& b = vertices[indices[1]];
+			const ImDrawVert& c = vertices[indices[2]];
+			const ImDrawVert& d = vertices[indices[5]];
+
+			if (a.col != b.col || a.col != c.col || a.col != d.col) return false;
+
+			// The two triangles only cover their whole bounding box if (a, c) and (b, d) are its two different diagonals.
+			if (a.pos.x == c.pos.x || a.pos.y == c.pos.y || b.pos.x == d.pos.x || b.pos.y == d.pos.y) return false;
+			if ((b.pos.x == a.pos.x && b.pos.y == a.pos.y) || (b.pos.x == c.pos.x && b.pos.y == c.pos.y)) return false;
+
+			bounds = Rect::CalculateBoundingBox(a, b, c);
+			if (!bounds.IsOnExtreme(a.pos) || !bounds.IsOnExtreme(b.pos) || !bounds.IsOnExtreme(c.pos) || !bounds.IsOnExtreme(d.pos)) return false;
+
+			bounds.MinU = std::min(bounds.MinU, d.uv.x);
+			bounds.MinV = std::min(bounds.MinV, d.uv.y);
+			bounds.MaxU = std::max(bounds.MaxU, d.uv.x);
+			bounds.MaxV = std::max(bounds.MaxV, d.uv.y);
+
+			corners[0] = &a;
+			corners[1] = &b;
+			corners[2] = &c;
+			corners[3] = &d;
+			return true;
+		}
+
+		// Pixels are covered by a rectangle if their centers are inside of it, same as with the triangle rasterizer.
+		SDL_Rect GetCoveredPixels(const Rect& bounds)
+		{
+			const int minX = static_cast<int>(SDL_ceil(bounds.MinX - 0.5f)), maxX = static_cast<int>(SDL_ceil(bounds.MaxX - 0.5f));
+			const int minY = static_cast<int>(SDL_ceil(bounds.MinY - 0.5f)), maxY = static_cast<int>(SDL_ceil(bounds.MaxY - 0.5f));
+			return SDL_Rect{ minX, minY, maxX - minX, maxY - minY };
+		}
+
+		// If a quad only samples the white pixel of the font texture, it can be drawn as a plain filled rectangle. Returns false if the six indices
+		// don't form such a quad. The resulting rectangle can be empty if the quad doesn't cover any pixel centers.
+		bool GetSolidRect(const ImDrawVert* vertices, const ImDrawIdx* indices, const ImVec2& whitePixel, SDL_Rect& rect, ImU32& color)
+		{
+			const ImDrawVert* corners[4];
+			Rect bounds;
+			if (!GetUniformQuad(vertices, indices, corners, bounds) || !bounds.UsesOnlyColor(whitePixel)) return false;
+
+			rect = GetCoveredPixels(bounds);
+			color = corners[0]->col;
+			return true;
+		}
+
+		// If a quad maps its corners to the corners of a rectangle of whole texels, it can be drawn as a copy of that rectangle with the color of the
+		// quad as color and alpha mod. This is what glyphs and images look like. Texture coordinates can be mirrored, which is returned as a flip.
+		// Returns false if the six indices don't form such a quad. The destination rectangle can be empty if the quad doesn't cover any pixel centers.
+		bool GetTexturedRect(const ImDrawVert* vertices, const ImDrawIdx* indices, int textureWidth, int textureHeight,
+			SDL_Rect& source, SDL_Rect& destination, SDL_RendererFlip& flip, ImU32& color)
+		{
+			const ImDrawVert* corners[4];
+			Rect bounds;
+			if (!GetUniformQuad(vertices, indices, corners, bounds)) return false;
+
+			// The horizontal texture coordinate may only depend on the horizontal position and the vertical one only on the vertical position,
+			// anything else is a rotated or sheared mapping.
+			// The diagonal (a, c) sets all four of them, the other two corners have to agree.
+			float left = 0.0f, right = 0.0f, top = 0.0f, bottom = 0.0f;
+			for (int i = 0; i < 4; i++)
+			{
+				const ImDrawVert* corner = corners[i < 2 ? i * 2 : (i - 2) * 2 + 1];
+				float& u = corner->pos.x == bounds.MinX ? left : right;
+				float& v = corner->pos.y == bounds.MinY ? top : bottom;
+				if (i < 2)
+				{
+					u = corner->uv.x;
+					v = corner->uv.y;
+				}
+				else if (u != corner->uv.x || v != corner->uv.y) return false;
+			}
+
+			const float minX = std::min(left, right) * textureWidth, maxX = std::max(left, right) * textureWidth;
+			const float minY = std::min(top, bottom) * textureHeight, maxY = std::max(top, bottom) * textureHeight;
+			source = { static_cast<int>(SDL_floor(minX + 0.5f)), static_cast<int>(SDL_floor(minY + 0.5f)),
+				static_cast<int>(SDL_floor(maxX + 0.5f)), static_cast<int>(SDL_floor(maxY + 0.5f)) };
+
+			// Texture coordinates between texels would need filtering, which a copy can't do the same way the rasterizer does.
+			static constexpr float tolerance = 1.0f / 64.0f;
+			if (SDL_fabs(minX - source.x) > tolerance || SDL_fabs(maxX - source.w) > tolerance) return false;
+			if (SDL_fabs(minY - source.y) > tolerance || SDL_fabs(maxY - source.h) > tolerance) return false;
+			source.w -= source.x;
+			source.h -= source.y;
+			if (source.w <= 0 || source.h <= 0) return false;
+
+			destination = GetCoveredPixels(bounds);
+			flip = static_cast<SDL_RendererFlip>((left > right ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE) | (top > bottom ? SDL_FLIP_VERTICAL : SDL_FLIP_NONE));
+			color = corners[0]->col;
+			return true;
+		}
+
+		// ImGui fills convex polygons with a fan of triangles around their first point. Antialiased polygons have an inner and an outer vertex for
+		// every point, and the fan is followed by a fringe of two triangles for every edge, from the inner outline out to the transparent one.
+		struct ConvexFan
+		{
+			// The first vertex of the polygon and the number of points of its outline.
+			unsigned int Base;
+			unsigned int Points;
+			bool Antialiased;
+			// The indices used by the fan and its fringe.
+			unsigned int IndexCount;
+		};
+
+		// Returns false if the indices don't start with a fan of at least two triangles, or an antialiased one of at least one.
+		bool GetConvexFan(const ImDrawIdx* indices, unsigned int indexCount, ConvexFan& fan)
+		{
+			if (indexCount < 6) return false;
+
+			const unsigned int base = indices[0];
+			const unsigned int stride = indices[1] - base;
+			if (indices[1] <= base || (stride != 1 && stride != 2)) return false;
+
+			unsigned int triangles = 0;
+			for (; 3 * (triangles + 1) <= indexCount; triangles++)
+			{
+				const ImDrawIdx* triangle = indices + 3 * triangles;
+				if (triangle[0] != base || triangle[1] != base + (triangles + 1) * stride || triangle[2] != base + (triangles + 2) * stride) break;
+			}
+			// A single triangle only counts if it's followed by a fringe.
+			if (triangles < (stride == 2 ? 1u : 2u)) return false;
+
+			fan = ConvexFan{ base, triangles + 2, stride == 2, triangles * 3 };
+			if (!fan.Antialiased) return true;
+
+			// The fringe starts with the edge from the last point to the first one.
+			if (fan.IndexCount + fan.Points * 6 > indexCount) return false;
+			const ImDrawIdx* fringe = indices + fan.IndexCount;
+			for (unsigned int i0 = fan.Points - 1, i1 = 0; i1 < fan.Points; i0 = i1++, fringe += 6)
+			{
+				const unsigned int inner0 = base + i0 * 2, inner1 = base + i1 * 2;
+				if (fringe[0] != inner1 || fringe[1] != inner0 || fringe[2] != inner0 + 1
+					|| fringe[3] != inner0 + 1 || fringe[4] != inner1 + 1 || fringe[5] != inner1) return false;
+			}
+			fan.IndexCount += fan.Points * 6;
+			return true;
+		}
+
+		// A run of triangles that ImGui added as one shape, like an antialiased line with its fringe. ImGui reserves new vertices for every shape, so
+		// the triangles of a shape only use the vertices [Base, Base + VertexCount), and every one of them after the first uses a vertex that an
+		// earlier one used as well. Fans are runs too, they're told apart by the fan they were found with, which is null for all other runs.
+		struct TriangleRun
+		{
+			unsigned int Base;
+			unsigned int VertexCount;
+			unsigned int IndexCount;
+			const ConvexFan* Fan;
+		};
+
+		// Runs of fewer triangles aren't worth a cache item of their own, the quads that most shapes are made of are cached per triangle.
+		static const unsigned int MinimumRunTriangles = 4;
+
+		// Returns false if the indices don't start with a run of at least MinimumRunTriangles triangles.
+		bool GetTriangleRun(const ImDrawIdx* indices, unsigned int indexCount, TriangleRun& run)
+		{
+			if (indexCount < MinimumRunTriangles * 3) return false;
+
+			unsigned int minimum = std::min({ indices[0], indices[1], indices[2] });
+			unsigned int maximum = std::max({ indices[0], indices[1], indices[2] });
+			unsigned int count = 3;
+			for (; count + 3 <= indexCount; count += 3)
+			{
+				const ImDrawIdx* triangle = indices + count;
+				const unsigned int low = std::min({ triangle[0], triangle[1], triangle[2] });
+				if (low < minimum || low > maximum) break;
+				maximum = std::max<unsigned int>({ maximum, triangle[0], triangle[1], triangle[2] });
+			}
+			if (count < MinimumRunTriangles * 3) return false;
+
+			run = TriangleRun{ minimum, maximum - minimum + 1, count, nullptr };
+			return true;
+		}
+
+		// The outline of antialiased polygons is halfway between their inner and outer vertices.
+		ImVec2 GetFanPoint(const ImDrawVert* vertices, const ConvexFan& fan, unsigned int point)
+		{
+			if (!fan.Antialiased) return vertices[fan.Base + point].pos;
+
+			const ImVec2& inner = vertices[fan.Base + point * 2].pos;
+			const ImVec2& outer = vertices[fan.Base + point * 2 + 1].pos;
+			return ImVec2((inner.x + outer.x) * 0.5f, (inner.y + outer.y) * 0.5f);
+		}
+
+		// If a fan is a single colored rectangle on whole pixels with (some) rounded corners, like the backgrounds of windows, frames and buttons,
+		// returns the rectangle and the radius of each corner (zero for corners that aren't rounded). The arcs of the corners are only checked at
+		// the points of the outline, so they're drawn as actual arcs and not as the segments between those points.
+		bool GetRoundedRect(const ImDrawVert* vertices, const ConvexFan& fan, const ImVec2& whitePixel, SDL_Rect& rect, float (&radii)[4], ImU32& color)
+		{
+			static constexpr float tolerance = 1.0f / 32.0f;
+
+			// The inner vertices have the color of the polygon, the outer vertices of antialiased polygons the same color but transparent.
+			color = vertices[fan.Base].col;
+			const unsigned int stride = fan.Antialiased ? 2 : 1;
+			for (unsigned int i = 0; i < fan.Points * stride; i++)
+			{
+				const ImDrawVert& vertex = vertices[fan.Base + i];
+				const bool isOuter = fan.Antialiased && (i & 1);
+				if (vertex.col != (isOuter ? (color & ~IM_COL32_A_MASK) : color)) return false;
+				if (vertex.uv.x != whitePixel.x || vertex.uv.y != whitePixel.y) return false;
+			}
+
+			float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+			for (unsigned int i = 0; i < fan.Points; i++)
+			{
+				const ImVec2 point = GetFanPoint(vertices, fan, i);
+				minX = std::min(minX, point.x); maxX = std::max(maxX, point.x);
+				minY = std::min(minY, point.y); maxY = std::max(maxY, point.y);
+			}
+
+			rect = { static_cast<int>(SDL_floor(minX + 0.5f)), static_cast<int>(SDL_floor(minY + 0.5f)), 0, 0 };
+			rect.w = static_cast<int>(SDL_floor(maxX + 0.5f)) - rect.x;
+			rect.h = static_cast<int>(SDL_floor(maxY + 0.5f)) - rect.y;
+			if (SDL_fabs(minX - rect.x) > tolerance || SDL_fabs(minY - rect.y) > tolerance) return false;
+			if (SDL_fabs(maxX - rect.x - rect.w) > tolerance || SDL_fabs(maxY - rect.y - rect.h) > tolerance) return false;
+			if (rect.w <= 0 || rect.h <= 0) return false;
+
+			// The radius of a corner is how far the outline stays away from it along both of its edges.
+			float alongX[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX }, alongY[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+			for (unsigned int i = 0; i < fan.Points; i++)
+			{
+				const ImVec2 point = GetFanPoint(vertices, fan, i);
+				if (SDL_fabs(point.y - minY) <= tolerance)
+				{
+					alongX[Device::TopLeft] = std::min(alongX[Device::TopLeft], point.x - minX);
+					alongX[Device::TopRight] = std::min(alongX[Device::TopRight], maxX - point.x);
+				}
+				if (SDL_fabs(point.y - maxY) <= tolerance)
+				{
+					alongX[Device::BottomLeft] = std::min(alongX[Device::BottomLeft], point.x - minX);
+					alongX[Device::BottomRight] = std::min(alongX[Device::BottomRight], maxX - point.x);
+				}
+				if (SDL_fabs(point.x - minX) <= tolerance)
+				{
+					alongY[Device::TopLeft] = std::min(alongY[Device::TopLeft], point.y - minY);
+					alongY[Device::BottomLeft] = std::min(alongY[Device::BottomLeft], maxY - point.y);
+				}
+				if (SDL_fabs(point.x - maxX) <= tolerance)
+				{
+					alongY[Device::TopRight] = std::min(alongY[Device::TopRight], point.y - minY);
+					alongY[Device::BottomRight] = std::min(alongY[Device::BottomRight], maxY - point.y);
+				}
+			}
+
+			bool isRounded = false;
+			for (int corner = 0; corner < 4; corner++)
+			{
+				if (alongX[corner] == FLT_MAX || SDL_fabs(alongX[corner] - alongY[corner]) > tolerance) return false;
+				radii[corner] = alongX[corner] > tolerance ? alongX[corner] : 0.0f;
+				isRounded |= radii[corner] >= 0.5f;
+			}
+			if (!isRounded) return false;
+
+			// Corners that are copied from sprites cover whole pixels, those must not overlap.
+			int sizes[4];
+			for (int corner = 0; corner < 4; corner++) sizes[corner] = static_cast<int>(SDL_ceil(radii[corner]));
+			if (sizes[Device::TopLeft] + sizes[Device::TopRight] > rect.w || sizes[Device::BottomLeft] + sizes[Device::BottomRight] > rect.w) return false;
+			if (sizes[Device::TopLeft] + sizes[Device::BottomLeft] > rect.h || sizes[Device::TopRight] + sizes[Device::BottomRight] > rect.h) return false;
+
+			// Every point has to be on one of the arcs or on one of the straight edges, and every arc needs a point in between its ends.
+			const ImVec2 centers[4] = {
+				ImVec2(minX + radii[Device::TopLeft], minY + radii[Device::TopLeft]),
+				ImVec2(maxX - radii[Device::TopRight], minY + radii[Device::TopRight]),
+				ImVec2(maxX - radii[Device::BottomRight], maxY - radii[Device::BottomRight]),
+				ImVec2(minX + radii[Device::BottomLeft], maxY - radii[Device::BottomLeft])
+			};
+			bool hasArcPoint[4] = { radii[0] == 0.0f, radii[1] == 0.0f, radii[2] == 0.0f, radii[3] == 0.0f };
+			for (unsigned int i = 0; i < fan.Points; i++)
+			{
+				const ImVec2 point = GetFanPoint(vertices, fan, i);
+				const bool onEdge = SDL_fabs(point.x - minX) <= tolerance || SDL_fabs(point.x - maxX) <= tolerance
+					|| SDL_fabs(point.y - minY) <= tolerance || SDL_fabs(point.y - maxY) <= tolerance;
+				if (onEdge) continue;
+
+				bool onArc = false;
+				for (int corner = 0; corner < 4 && !onArc; corner++)
+				{
+					const float dx = point.x - centers[corner].x, dy = point.y - centers[corner].y;
+					const bool isLeft = corner == Device::TopLeft || corner == Device::BottomLeft;
+					const bool isTop = corner == Device::TopLeft || corner == Device::TopRight;
+					if (radii[corner] == 0.0f || (isLeft ? dx > 0.0f : dx < 0.0f) || (isTop ? dy > 0.0f : dy < 0.0f)) continue;
+
+					onArc = SDL_fabs(std::sqrt(dx * dx + dy * dy) - radii[corner]) <= tolerance;
+					hasArcPoint[corner] |= onArc;
+				}
+				if (!onArc) return false;
+			}
+			return hasArcPoint[0] && hasArcPoint[1] && hasArcPoint[2] && hasArcPoint[3];
+		}
+
+		// Returns false if the triangle doesn't have an area, and there is nothing to draw. The texture size is used to scale the texture coordinates
+		// to texels, it can be zero for triangles that don't use a texture.
+		bool SetupTriangle(ImDrawVert v1, ImDrawVert v2, ImDrawVert v3, int textureWidth, int textureHeight, TriangleSetup& setup)
+		{
+			// This function operates in s28.4 fixed point: it's more precise than
+			// floating point and often faster. This also effectively lets us work in
+			// a subpixel space where each pixel is divided into 256 subpixels.
+			// TODO: check for overflow
+
+			// Find integral bounding box, scale to fixed point. We use this to
+			// iterate over all pixels possibly covered by the triangle.
+			const Sint32 minXf = SDL_floor(SDL_min(v1.pos.x, SDL_min(v2.pos.x, v3.pos.x))) * 16;
+			const Sint32 minYf = SDL_floor(SDL_min(v1.pos.y, SDL_min(v2.pos.y, v3.pos.y))) * 16;
+			const Sint32 maxXf = SDL_ceil(SDL_max(v1.pos.x, SDL_max(v2.pos.x, v3.pos.x))) * 16;
+			const Sint32 maxYf = SDL_ceil(SDL_max(v1.pos.y, SDL_max(v2.pos.y, v3.pos.y))) * 16;
+
+			// Find center of bounding box, used for translating coordinates.
+			// This accomplishes two things: 1) makes the fixed point calculations less
+			// likely to overflow 2) makes it less likely that triangles will be rendered
+			// differently on different parts of the screen (seems to happen sometimes
+			// with fractional coordinates). Make sure they're on integer boundaries too,
+			// to make it easy to calculate our starting position.
+			const Sint32 meanXf = round((maxXf - minXf) / 2 / 16) * 16;
+			const Sint32 meanYf = round((maxYf - minYf) / 2 / 16) * 16;
+
+			// Translate vertex coordinates with respect to the center of the bounding
+			// box, and scale to fixed point.
+			Sint32 f1x = round(v1.pos.x * 16) - meanXf;
+			Sint32 f1y = round(v1.pos.y * 16) - meanYf;
+			Sint32 f2x = round(v2.pos.x * 16) - meanXf;
+			Sint32 f2y = round(v2.pos.y * 16) - meanYf;
+			Sint32 f3x = round(v3.pos.x * 16) - meanXf;
+			Sint32 f3y = round(v3.pos.y * 16) - meanYf;
+
+			// Calculate starting position for iteration. It's the top-left of our
+			// bounding box with respect to the center of the bounding box. We add a
+			// half-pixel on each axis to match hardware renderers, which evaluate at the
+			// center of pixels.
+			const Sint32 px = minXf - meanXf + 8;
+			const Sint32 py = minYf - meanYf + 8;
+
+			// Calculate barycentric coordinates at starting position. Barycentric
+			// coordinates tell us the position of a point with respect to the
+			// edges/vertices of a triangle: we can easily use these to calculate if
+			// a point is inside a triangle (the three barycentric coordinates will all
+			// be positive) and how to interpolate vertex attributes (multiply them by
+			// the normalized barycentric coordinates at that point.)
+			Sint32 w1 = (f3x - f2x) * (py - f2y) - (f3y - f2y) * (px - f2x);
+			Sint32 w2 = (f1x - f3x) * (py - f3y) - (f1y - f3y) * (px - f3x);
+			Sint32 w3 = (f2x - f1x) * (py - f1y) - (f2y - f1y) * (px - f1x);
+
+			// Calculate the normalization factor for transforming our barycentric
+			// coordinates into interpolation constants. If it's negative, then the
+			// triangle is back-facing (wound the wrong way), and we flip two vertices
+			// to make it front-facing. Keep this factor as a float since 1) we'll be
+			// dividing by it later 2) we don't lose precision going through the raster
+			// loop.
+			float normalization = (w1 + w2 + w3);
+			if (normalization == 0) return false;
+			if (normalization < 0) {
+				ImDrawVert vswap = v3;
+				v3 = v2;
+				v2 = vswap;
+
+				Sint32 fxswap = f3x;
+				f3x = f2x;
+				f2x = fxswap;
+				Sint32 fyswap = f3y;
+				f3y = f2y;
+				f2y = fyswap;
+
+				Sint32 wswap = w3;
+				w3 = -w2;
+				w2 = -wswap;
+				w1 = -w1;
+
+				normalization = -normalization;
+			}
+
+			// We deal with shared edges between triangles by defining a fill rule: only
+			// edges on the top or left of the triangle will be filled. We could change
+			// the comparison in the loop below to differentiate between greater-than
+			// and greater-or-equal-than, but since we're in fixed point space where
+			// everything is an integer we instead add a bias to each barycentric
+			// coordinate corresponding to a non-top, non-left edge.
+			setup.Bias1 = ((f3y == f2y && f3x > f2x) || f3x < f2x) ? 0 : -1;
+			setup.Bias2 = ((f3y == f1y && f1x > f3x) || f1x < f3x) ? 0 : -1;
+			setup.Bias3 = ((f2y == f1y && f2x > f1x) || f2x < f1x) ? 0 : -1;
+			setup.W1 = w1 + setup.Bias1;
+			setup.W2 = w2 + setup.Bias2;
+			setup.W3 = w3 + setup.Bias3;
+
+			// As we go through each pixel, we use the barycentric coordinates to check
+			// if they're covered by the triangle. We could recalculate them every time,
+			// but since they're linear we can calculate the linear factors with respect
+			// to advancing through columns and rows and just add each time through the
+			// loop. We multiply to get from subpixel space back to pixel space, since
+			// we'll be iterating pixel by pixel.
+			setup.A1 = (f2y - f3y) * 16;
+			setup.A2 = (f3y - f1y) * 16;
+			setup.A3 = (f1y - f2y) * 16;
+			setup.B1 = (f3x - f2x) * 16;
+			setup.B2 = (f1x - f3x) * 16;
+			setup.B3 = (f2x - f1x) * 16;
+
+			setup.MinX = minXf / 16;
+			setup.MinY = minYf / 16;
+			setup.MaxX = maxXf / 16;
+			setup.MaxY = maxYf / 16;
+
+			// Precalculate normalized vertex attributes. We just need to multiply these
+			// by the barycentric coordinates and sum them to get the interpolated vertex
+			// attribute for any point. This can save a few frames per second.
+			const ImDrawVert* vertices[3] = { &v1, &v2, &v3 };
+			for (int i = 0; i < 3; i++)
+			{
+				const Color color(vertices[i]->col);
+				setup.R[i] = color.R * 255 / normalization;
+				setup.G[i] = color.G * 255 / normalization;
+				setup.B[i] = color.B * 255 / normalization;
+				setup.A[i] = color.A * 255 / normalization;
+				setup.U[i] = vertices[i]->uv.x * textureWidth / normalization;
+				setup.V[i] = vertices[i]->uv.y * textureHeight / normalization;
+			}
+
+			setup.IsUniformColor = v1.col == v2.col && v1.col == v3.col;
+			setup.UniformColor = v1.col;
+			return true;
+		}
+
+		// The vector kernels below have to round exactly like the scalar one, so a multiplication must not be fused with the addition that follows
+		// into an FMA instruction, which compilers do for some targets (like with -march=native). Every product goes through Unfused, which hides
+		// it from the optimizer without costing an instruction, so the kernels round the same whatever contraction mode they're compiled with.
+		float Unfused(float value)
+		{
+			IMGUI_SDL_UNFUSED(value);
+			return value;
+		}
+
+		// Interpolates a value of the vertices at a pixel, given its barycentric coordinates.
+		float Interpolate(const float (&values)[3], Sint32 alpha, Sint32 beta, Sint32 gamma)
+		{
+			return Unfused(values[0] * alpha) + Unfused(values[1] * beta) + Unfused(values[2] * gamma);
+		}
+
+		// Interpolates the vertex colors at a pixel, given its biased barycentric coordinates.
+		void InterpolateColor(const TriangleSetup& t, Sint32 w1, Sint32 w2, Sint32 w3, Uint8& r, Uint8& g, Uint8& b, Uint8& a)
+		{
+			// Fix the adjustment due to fill rule. It's incorrect when calculating
+			// interpolation values.
+			const Sint32 alpha = w1 - t.Bias1;
+			const Sint32 beta = w2 - t.Bias2;
+			const Sint32 gamma = w3 - t.Bias3;
+
+			r = Interpolate(t.R, alpha, beta, gamma);
+			g = Interpolate(t.G, alpha, beta, gamma);
+			b = Interpolate(t.B, alpha, beta, gamma);
+			a = Interpolate(t.A, alpha, beta, gamma);
+		}
+
+		void InterpolateTexel(const TriangleSetup& t, Sint32 w1, Sint32 w2, Sint32 w3, int& u, int& v)
+		{
+			const Sint32 alpha = w1 - t.Bias1;
+			const Sint32 beta = w2 - t.Bias2;
+			const Sint32 gamma = w3 - t.Bias3;
+
+			u = Interpolate(t.U, alpha, beta, gamma);
+			v = Interpolate(t.V, alpha, beta, gamma);
+		}
+
+		// The inner loops of the rasterizer. FindEdge returns the index of the first of count pixels whose coverage matches the covered flag
+		// (or count if there is none), starting at the given biased barycentric coordinates and stepping them by (a1, a2, a3) for every pixel.
+		// ShadeSpan interpolates the color (and texel) of count covered pixels and writes them to the output.
+		//
+		// There is a scalar implementation, and SSE2 and AVX2 ones that handle 4 or 8 pixels at once. The best one supported by the CPU is picked
+		// at runtime. The vector versions do the exact same integer and float operations in the same order, so their output is identical to the scalar
+		// one. That is checked once before they're picked, since flags like -ffast-math can still change how either of them rounds.
+		struct RasterKernel
+		{
+			const char* Name;
+			int (*FindEdge)(Sint32 w1, Sint32 w2, Sint32 w3, Sint32 a1, Sint32 a2, Sint32 a3, int count, bool covered);
+			void (*ShadeSpan)(const TriangleSetup& t, Sint32 w1, Sint32 w2, Sint32 w3, int count, const PixelSource* texture, ImU32* out);
+		};
+
+		int FindEdgeScalar(Sint32 w1, Sint32 w2, Sint32 w3, Sint32 a1, Sint32 a2, Sint32 a3, int count, bool covered)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				// If all barycentric coordinates are positive, we're inside the triangle.
+				if (((w1 | w2 | w3) >= 0) == covered) return i;
+
+				w1 += a1;
+				w2 += a2;
+				w3 += a3;
+			}
+			return count;
+		}
+
+		void ShadeSpanScalar(const TriangleSetup& t, Sint32 w1, Sint32 w2, Sint32 w3, int count, const PixelSource* texture, ImU32* out)
+		{
+			for (int i = 0; i < count; i++, w1 += t.A1, w2 += t.A2, w3 += t.A3)
+			{
+				Uint8 r, g, b, a;
+				InterpolateColor(t, w1, w2, w3, r, g, b, a);
+				ImU32 color = PackColor(r, g, b, a);
+
+				if (texture)
+				{
+					int u, v;
+					InterpolateTexel(t, w1, w2, w3, u, v);
+					u = std::min(std::max(u, 0), texture->Width - 1);
+					v = std::min(std::max(v, 0), texture->Height - 1);
+					color = Modulate(texture->Pixels[v * texture->Width + u], color);
+				}
+
+				out[i] = color;
+			}
+		}
+
+#if IMGUI_SDL_HAS_SSE2 || IMGUI_SDL_HAS_AVX2
+		int CountTrailingZeros(unsigned int value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return static_cast<int>(index);
+#else
+			return __builtin_ctz(value);
+#endif
+		}
+#endif
+
+#if IMGUI_SDL_HAS_SSE2
+		int FindEdgeSSE2(Sint32 w1, Sint32 w2, Sint32 w3, Sint32 a1, Sint32 a2, Sint32 a3, int count, bool covered)
+		{
+			__m128i v1 = _mm_add_epi32(_mm_set1_epi32(w1), _mm_setr_epi32(0, a1, a1 * 2, a1 * 3));
+			__m128i v2 = _mm_add_epi32(_mm_set1_epi32(w2), _mm_setr_epi32(0, a2, a2 * 2, a2 * 3));
+			__m128i v3 = _mm_add_epi32(_mm_set1_epi32(w3), _mm_setr_epi32(0, a3, a3 * 2, a3 * 3));
+			const __m128i step1 = _mm_set1_epi32(a1 * 4), step2 = _mm_set1_epi32(a2 * 4), step3 = _mm_set1_epi32(a3 * 4);
+
+			for (int i = 0; i < count; i += 4)
+			{
+				// The sign bit of the combined coordinates is set for every pixel outside of the triangle.
+				const int outside = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_or_si128(v1, v2), v3)));
+				const int matches = covered ? ~outside & 0xf : outside;
+				if (matches) return std::min(i + CountTrailingZeros(matches), count);
+
+				v1 = _mm_add_epi32(v1, step1);
+				v2 = _mm_add_epi32(v2, step2);
+				v3 = _mm_add_epi32(v3, step3);
+			}
+			return count;
+		}
+
+		// Divides each 16 bit product of two 8 bit channels by 255 with rounding, the same as Modulate.
+		__m128i Divide255SSE2(__m128i products)
+		{
+			const __m128i x = _mm_add_epi16(products, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+		}
+
+		__m128i ModulateSSE2(__m128i first, __m128i second)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i low = _mm_mullo_epi16(_mm_unpacklo_epi8(first, zero), _mm_unpacklo_epi8(second, zero));
+			const __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(first, zero), _mm_unpackhi_epi8(second, zero));
+			return _mm_packus_epi16(Divide255SSE2(low), Divide255SSE2(high));
+		}
+
+		// Clamps to [0, max]. SSE2 doesn't have 32 bit integer min and max instructions, so it's done with comparisons.
+		__m128i ClampSSE2(__m128i value, int max)
+		{
+			const __m128i maximum = _mm_set1_epi32(max);
+			value = _mm_andnot_si128(_mm_cmplt_epi32(value, _mm_setzero_si128()), value);
+			const __m128i above = _mm_cmpgt_epi32(value, maximum);
+			return _mm_or_si128(_mm_and_si128(above, maximum), _mm_andnot_si128(above, value));
+		}
+
+		__m128 UnfusedSSE2(__m128 value)
+		{
+			IMGUI_SDL_UNFUSED(value);
+			return value;
+		}
+
+		__m128 InterpolateSSE2(const float (&values)[3], __m128 alpha, __m128 beta, __m128 gamma)
+		{
+			return _mm_add_ps(_mm_add_ps(UnfusedSSE2(_mm_mul_ps(_mm_set1_ps(values[0]), alpha)), UnfusedSSE2(_mm_mul_ps(_mm_set1_ps(values[1]), beta))),
+				UnfusedSSE2(_mm_mul_ps(_mm_set1_ps(values[2]), gamma)));
+		}
+
+		// Converts interpolated channel values to bytes the way a scalar float to Uint8 conversion does: truncate, then keep the lowest byte.
+		__m128i ChannelSSE2(const float (&values)[3], __m128 alpha, __m128 beta, __m128 gamma)
+		{
+			return _mm_and_si128(_mm_cvttps_epi32(InterpolateSSE2(values, alpha, beta, gamma)), _mm_set1_epi32(0xff));
+		}
+
+		void ShadeSpanSSE2(const TriangleSetup& t, Sint32 w1, Sint32 w2, Sint32 w3, int count, const PixelSource* texture, ImU32* out)
+		{
+			__m128i alpha = _mm_add_epi32(_mm_set1_epi32(w1 - t.Bias1), _mm_setr_epi32(0, t.A1, t.A1 * 2, t.A1 * 3));
+			__m128i beta = _mm_add_epi32(_mm_set1_epi32(w2 - t.Bias2), _mm_setr_epi32(0, t.A2, t.A2 * 2, t.A2 * 3));
+			__m128i gamma = _mm_add_epi32(_mm_set1_epi32(w3 - t.Bias3), _mm_setr_epi32(0, t.A3, t.A3 * 2, t.A3 * 3));
+			const __m128i step1 = _mm_set1_epi32(t.A1 * 4), step2 = _mm_set1_epi32(t.A2 * 4), step3 = _mm_set1_epi32(t.A3 * 4);
+
+			for (int i = 0; i < count; i += 4)
+			{
+				const __m128 fa = _mm_cvtepi32_ps(alpha), fb = _mm_cvtepi32_ps(beta), fc = _mm_cvtepi32_ps(gamma);
+
+				const __m128i r = ChannelSSE2(t.R, fa, fb, fc);
+				const __m128i g = ChannelSSE2(t.G, fa, fb, fc);
+				const __m128i b = ChannelSSE2(t.B, fa, fb, fc);
+				const __m128i a = ChannelSSE2(t.A, fa, fb, fc);
+				__m128i colors = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+
+				if (texture)
+				{
+					const __m128 u = InterpolateSSE2(t.U, fa, fb, fc);
+					const __m128 v = InterpolateSSE2(t.V, fa, fb, fc);
+
+					// There is no gather in SSE2, the texels are fetched one by one.
+					alignas(16) Sint32 us[4], vs[4];
+					_mm_store_si128(reinterpret_cast<__m128i*>(us), ClampSSE2(_mm_cvttps_epi32(u), texture->Width - 1));
+					_mm_store_si128(reinterpret_cast<__m128i*>(vs), ClampSSE2(_mm_cvttps_epi32(v), texture->Height - 1));
+					const __m128i texels = _mm_setr_epi32(
+						static_cast<int>(texture->Pixels[vs[0] * texture->Width + us[0]]),
+						static_cast<int>(texture->Pixels[vs[1] * texture->Width + us[1]]),
+						static_cast<int>(texture->Pixels[vs[2] * texture->Width + us[2]]),
+						static_cast<int>(texture->Pixels[vs[3] * texture->Width + us[3]]));
+					colors = ModulateSSE2(texels, colors);
+				}
+
+				if (count - i >= 4)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), colors);
+				}
+				else
+				{
+					alignas(16) ImU32 rest[4];
+					_mm_store_si128(reinterpret_cast<__m128i*>(rest), colors);
+					std::copy(rest, rest + (count - i), out + i);
+				}
+
+				alpha = _mm_add_epi32(alpha, step1);
+				beta = _mm_add_epi32(beta, step2);
+				gamma = _mm_add_epi32(gamma, step3);
+			}
+		}
+#endif
+
+#if IMGUI_SDL_HAS_AVX2
+		IMGUI_SDL_TARGET_AVX2 int FindEdgeAVX2(Sint32 w1, Sint32 w2, Sint32 w3, Sint32 a1, Sint32 a2, Sint32 a3, int count, bool covered)
+		{
+			const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			__m256i v1 = _mm256_add_epi32(_mm256_set1_epi32(w1), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(a1)));
+			__m256i v2 = _mm256_add_epi32(_mm256_set1_epi32(w2), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(a2)));
+			__m256i v3 = _mm256_add_epi32(_mm256_set1_epi32(w3), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(a3)));
+			const __m256i step1 = _mm256_set1_epi32(a1 * 8), step2 = _mm256_set1_epi32(a2 * 8), step3 = _mm256_set1_epi32(a3 * 8);
+
+			for (int i = 0; i < count; i += 8)
+			{
+				const int outside = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(_mm256_or_si256(v1, v2), v3)));
+				const int matches = covered ? ~outside & 0xff : outside;
+				if (matches) return std::min(i + CountTrailingZeros(matches), count);
+
+				v1 = _mm256_add_epi32(v1, step1);
+				v2 = _mm256_add_epi32(v2, step2);
+				v3 = _mm256_add_epi32(v3, step3);
+			}
+			return count;
+		}
+
+		IMGUI_SDL_TARGET_AVX2 __m256i Divide255AVX2(__m256i products)
+		{
+			const __m256i x = _mm256_add_epi16(products, _mm256_set1_epi16(128));
+			return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+		}
+
+		// The unpacks and the pack work within each 128 bit half, so the pixel order comes out the same as it went in.
+		IMGUI_SDL_TARGET_AVX2 __m256i ModulateAVX2(__m256i first, __m256i second)
+		{
+			const __m256i zero = _mm256_setzero_si256();
+			const __m256i low = _mm256_mullo_epi16(_mm256_unpacklo_epi8(first, zero), _mm256_unpacklo_epi8(second, zero));
+			const __m256i high = _mm256_mullo_epi16(_mm256_unpackhi_epi8(first, zero), _mm256_unpackhi_epi8(second, zero));
+			return _mm256_packus_epi16(Divide255AVX2(low), Divide255AVX2(high));
+		}
+
+		IMGUI_SDL_TARGET_AVX2 __m256 UnfusedAVX2(__m256 value)
+		{
+			IMGUI_SDL_UNFUSED(value);
+			return value;
+		}
+
+		IMGUI_SDL_TARGET_AVX2 __m256 InterpolateAVX2(const float (&values)[3], __m256 alpha, __m256 beta, __m256 gamma)
+		{
+			return _mm256_add_ps(_mm256_add_ps(UnfusedAVX2(_mm256_mul_ps(_mm256_set1_ps(values[0]), alpha)), UnfusedAVX2(_mm256_mul_ps(_mm256_set1_ps(values[1]), beta))),
+				UnfusedAVX2(_mm256_mul_ps(_mm256_set1_ps(values[2]), gamma)));
+		}
+
+		IMGUI_SDL_TARGET_AVX2 __m256i ChannelAVX2(const float (&values)[3], __m256 alpha, __m256 beta, __m256 gamma)
+		{
+			return _mm256_and_si256(_mm256_cvttps_epi32(InterpolateAVX2(values, alpha, beta, gamma)), _mm256_set1_epi32(0xff));
+		}
+
+		IMGUI_SDL_TARGET_AVX2 __m256i TexelAVX2(const float (&values)[3], __m256 alpha, __m256 beta, __m256 gamma, int max)
+		{
+			const __m256i value = _mm256_cvttps_epi32(InterpolateAVX2(values, alpha, beta, gamma));
+			return _mm256_min_epi32(_mm256_max_epi32(value, _mm256_setzero_si256()), _mm256_set1_epi32(max));
+		}
+
+		IMGUI_SDL_TARGET_AVX2 void ShadeSpanAVX2(const TriangleSetup& t, Sint32 w1, Sint32 w2, Sint32 w3, int count, const PixelSource* texture, ImU32* out)
+		{
+			const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			__m256i alpha = _mm256_add_epi32(_mm256_set1_epi32(w1 - t.Bias1), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(t.A1)));
+			__m256i beta = _mm256_add_epi32(_mm256_set1_epi32(w2 - t.Bias2), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(t.A2)));
+			__m256i gamma = _mm256_add_epi32(_mm256_set1_epi32(w3 - t.Bias3), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(t.A3)));
+			const __m256i step1 = _mm256_set1_epi32(t.A1 * 8), step2 = _mm256_set1_epi32(t.A2 * 8), step3 = _mm256_set1_epi32(t.A3 * 8);
+
+			for (int i = 0; i < count; i += 8)
+			{
+				const __m256 fa = _mm256_cvtepi32_ps(alpha), fb = _mm256_cvtepi32_ps(beta), fc = _mm256_cvtepi32_ps(gamma);
+
+				const __m256i r = ChannelAVX2(t.R, fa, fb, fc);
+				const __m256i g = ChannelAVX2(t.G, fa, fb, fc);
+				const __m256i b = ChannelAVX2(t.B, fa, fb, fc);
+				const __m256i a = ChannelAVX2(t.A, fa, fb, fc);
+				__m256i colors = _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_slli_epi32(a, 24)));
+
+				if (texture)
+				{
+					const __m256i u = TexelAVX2(t.U, fa, fb, fc, texture->Width - 1);
+					const __m256i v = TexelAVX2(t.V, fa, fb, fc, texture->Height - 1);
+					const __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(texture->Width)), u);
+					const __m256i texels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(texture->Pixels.data()), index, 4);
+					colors = ModulateAVX2(texels, colors);
+				}
+
+				if (count - i >= 8)
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), colors);
+				}
+				else
+				{
+					alignas(32) ImU32 rest[8];
+					_mm256_store_si256(reinterpret_cast<__m256i*>(rest), colors);
+					std::copy(rest, rest + (count - i), out + i);
+				}
+
+				alpha = _mm256_add_epi32(alpha, step1);
+				beta = _mm256_add_epi32(beta, step2);
+				gamma = _mm256_add_epi32(gamma, step3);
+			}
+		}
+#endif
+
+		// How many pixels a kernel got different from the scalar one, out of how many it shaded.
+		struct KernelComparison
+		{
+			int Triangles = 0;
+			size_t Pixels = 0;
+			size_t Mismatches = 0;
+		};
+
+		// Rasterizes pseudo random triangles of up to size pixels with the kernel and with the scalar one, with and without a texture, and compares
+		// the rows they produce pixel for pixel. A pixel that only one of them covers counts as a mismatch too. The same seed gives the same triangles.
+		KernelComparison CompareWithScalarKernel(const RasterKernel& kernel, Uint32 seed, int triangles, int size)
+		{
+			const auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+			PixelSource texture;
+			texture.Width = texture.Height = 16;
+			texture.Pixels.resize(static_cast<size_t>(texture.Width) * texture.Height);
+			for (ImU32& pixel : texture.Pixels) pixel = next() ^ (next() << 8);
+
+			const PixelSource* const sources[] = { nullptr, &texture };
+			const Uint32 positions = static_cast<Uint32>(std::max(size, 1)) * 64;
+			KernelComparison comparison;
+			std::vector<ImU32> expected, actual;
+			for (int n = 0; n < triangles; n++)
+			{
+				ImDrawVert vertices[3];
+				for (ImDrawVert& vertex : vertices)
+				{
+					vertex.pos = ImVec2((next() % positions) / 64.0f, (next() % positions) / 64.0f);
+					vertex.uv = ImVec2((next() % 1024) / 1024.0f, (next() % 1024) / 1024.0f);
+					vertex.col = next() ^ (next() << 8);
+				}
+
+				TriangleSetup t;
+				if (!SetupTriangle(vertices[0], vertices[1], vertices[2], texture.Width, texture.Height, t)) continue;
+				comparison.Triangles++;
+
+				const int width = t.MaxX - t.MinX + 1;
+				Sint32 w1 = t.W1, w2 = t.W2, w3 = t.W3;
+				for (int y = t.MinY; y <= t.MaxY; y++, w1 += t.B1, w2 += t.B2, w3 += t.B3)
+				{
+					for (const PixelSource* source : sources)
+					{
+						// Both kernels draw the whole row, so that a span that starts or ends somewhere else shows up as the pixels it got wrong.
+						const auto drawRow = [&](const RasterKernel& rowKernel, std::vector<ImU32>& row)
+						{
+							row.assign(width, 0);
+							const int start = rowKernel.FindEdge(w1, w2, w3, t.A1, t.A2, t.A3, width, true);
+							if (start == width) return;
+
+							const Sint32 s1 = w1 + start * t.A1, s2 = w2 + start * t.A2, s3 = w3 + start * t.A3;
+							const int count = rowKernel.FindEdge(s1, s2, s3, t.A1, t.A2, t.A3, width - start, false);
+							rowKernel.ShadeSpan(t, s1, s2, s3, count, source, row.data() + start);
+						};
+
+						drawRow(RasterKernel{ "scalar", FindEdgeScalar, ShadeSpanScalar }, expected);
+						drawRow(kernel, actual);
+						for (int x = 0; x < width; x++)
+						{
+							comparison.Pixels += expected[x] != 0 || actual[x] != 0;
+							comparison.Mismatches += expected[x] != actual[x];
+						}
+					}
+				}
+			}
+			return comparison;
+		}
+
+		bool MatchesScalarKernel(const RasterKernel& kernel)
+		{
+			return CompareWithScalarKernel(kernel, 0x9e3779b9, 64, 32).Mismatches == 0;
+		}
+
+		// The kernels this was compiled with that the CPU supports, from the widest one to the scalar one.
+		std::vector<RasterKernel> GetSupportedRasterKernels()
+		{
+			std::vector<RasterKernel> kernels;
+#if IMGUI_SDL_HAS_AVX2
+			if (SDL_HasAVX2()) kernels.push_back(RasterKernel{ "avx2", FindEdgeAVX2, ShadeSpanAVX2 });
+#endif
+#if IMGUI_SDL_HAS_SSE2
+			if (SDL_HasSSE2()) kernels.push_back(RasterKernel{ "sse2", FindEdgeSSE2, ShadeSpanSSE2 });
+#endif
+			kernels.push_back(RasterKernel{ "scalar", FindEdgeScalar, ShadeSpanScalar });
+			return kernels;
+		}
+
+		// Picks the widest kernel the CPU supports, unless it doesn't produce the same pixels as the scalar one with the flags this was compiled with.
+		// Cached triangles would otherwise look slightly different depending on the CPU. A kernel that is skipped that way is most likely a bug, so it's
+		// logged instead of quietly costing the speed up; benchmark --kernel-check shows which pixels it gets wrong.
+		RasterKernel SelectRasterKernel()
+		{
+			for (const RasterKernel& kernel : GetSupportedRasterKernels())
+			{
+				if (kernel.ShadeSpan == ShadeSpanScalar || MatchesScalarKernel(kernel)) return kernel;
+				SDL_Log("ImGuiSDL: the %s raster kernel doesn't produce the same pixels as the scalar one, falling back to a narrower one.", kernel.Name);
+			}
+			return RasterKernel{ "scalar", FindEdgeScalar, ShadeSpanScalar };
+		}
+
+		const RasterKernel& GetRasterKernel()
+		{
+			static const RasterKernel kernel = SelectRasterKernel();
+			return kernel;
+		}
+
+		// Calls the function for every row of the triangle with the range of pixels [start, end) that is covered by it, and with the biased barycentric
+		// coordinates of the first covered pixel. Triangles are convex, so each row has at most one such range.
+		template <typename Function> void ForEachSpan(const TriangleSetup& t, Function&& function)
+		{
+			const RasterKernel& kernel = GetRasterKernel();
+			const int width = t.MaxX - t.MinX + 1;
+			Sint32 w1Row = t.W1, w2Row = t.W2, w3Row = t.W3;
+
+			for (int y = t.MinY; y <= t.MaxY; y++)
+			{
+				// Skip the pixels to the left of the triangle, then find where the triangle ends on this row.
+				const int start = kernel.FindEdge(w1Row, w2Row, w3Row, t.A1, t.A2, t.A3, width, true);
+				if (start < width)
+				{
+					const Sint32 w1 = w1Row + start * t.A1;
+					const Sint32 w2 = w2Row + start * t.A2;
+					const Sint32 w3 = w3Row + start * t.A3;
+					const int end = start + kernel.FindEdge(w1, w2, w3, t.A1, t.A2, t.A3, width - start, false);
+
+					function(y, t.MinX + start, t.MinX + end, w1, w2, w3);
+				}
+
+				// Increment barycentric coordinates one pixel downwards
+				w1Row += t.B1;
+				w2Row += t.B2;
+				w3Row += t.B3;
+			}
+		}
+
+		// Shrinks the bounding box of the triangle to the rectangle. Returns false if nothing of the bounding box is left.
+		bool ClipTriangle(TriangleSetup& t, const SDL_Rect& rect)
+		{
+			const int minX = std::max(t.MinX, rect.x), maxX = std::min(t.MaxX, rect.x + rect.w - 1);
+			const int minY = std::max(t.MinY, rect.y), maxY = std::min(t.MaxY, rect.y + rect.h - 1);
+			if (minX > maxX || minY > maxY) return false;
+
+			// The barycentric coordinates have to be moved to the new top left pixel.
+			const int columns = minX - t.MinX, rows = minY - t.MinY;
+			t.W1 += columns * t.A1 + rows * t.B1;
+			t.W2 += columns * t.A2 + rows * t.B2;
+			t.W3 += columns * t.A3 + rows * t.B3;
+
+			t.MinX = minX;
+			t.MinY = minY;
+			t.MaxX = maxX;
+			t.MaxY = maxY;
+			return true;
+		}
+
+		// Draws a triangle to the current render target of the device using SDL draw calls. The offset is added to the pixels after rasterization.
+		// It's used instead of moving the vertices, so that a triangle always covers the same pixels no matter where it ends up. Only the pixels
+		// inside of the clip rect, which is in pixels of the triangle before the offset, are drawn. Returns the number of pixels that were drawn.
+		size_t DrawTriangle(RenderState& state, ImGuiSDL::Stats& stats, ImDrawVert v1, ImDrawVert v2, ImDrawVert v3, SDL_Texture *texture, const SDL_Point& offset,
+			const SDL_Rect& clip)
+		{
+			// The texture color and alpha mod are changed according to the vertex attributes. The render state restores them at the end of the
+			// frame, and skips setting them again for neighbouring pixels of the same color.
+			SDL_Renderer* renderer = state.GetRenderer();
+
+			// Store texture width and height for use in mapping vertex attributes
+			int texture_width = 0, texture_height = 0;
+			if (texture) {
+				SDL_QueryTexture(texture, NULL, NULL, &texture_width, &texture_height);
+			}
+
+			TriangleSetup setup;
+			if (!SetupTriangle(v1, v2, v3, texture_width, texture_height, setup) || !ClipTriangle(setup, clip)) return 0;
+
+			// If the triangle is uniformly-colored, we can get a big speed up by setting
+			// the color once and drawing batches of rows, rather than drawing individually
+			// colored pixels. Avoid malloc and a dynamic buffer size since it's slower
+			// than just grabbing space from the stack.
+			const bool isUniformColor = !texture && setup.IsUniformColor;
+			SDL_Rect rectsbuffer[1024];
+			int rects_i = 0;
+			size_t pixels = 0;
+			if (isUniformColor) {
+				state.SetDrawColor(v1.col);
+			}
+
+			ForEachSpan(setup, [&](int y, int start, int end, Sint32 w1, Sint32 w2, Sint32 w3) {
+				pixels += end - start;
+				if (isUniformColor) {
+					// For uniformly-colored triangles, store lines so we can send them
+					// to the renderer in batches. This provides a huge speedup in most
+					// cases (even with SDL 2.0.10's built-in batching!).
+					rectsbuffer[rects_i].x = start + offset.x;
+					rectsbuffer[rects_i].y = y + offset.y;
+					rectsbuffer[rects_i].w = end - start;
+					rectsbuffer[rects_i].h = 1;
+					rects_i++;
+					if (rects_i == 1024) {
+						SDL_RenderFillRects(renderer, rectsbuffer, rects_i);
+						stats.SDLCalls++;
+						rects_i = 0;
+					}
+					return;
+				}
+
+				for (int x = start; x < end; x++, w1 += setup.A1, w2 += setup.A2, w3 += setup.A3) {
+					Uint8 r, g, b, a;
+					InterpolateColor(setup, w1, w2, w3, r, g, b, a);
+
+					if (!texture) {
+						// Draw a single colored pixel
+						state.SetDrawColor(PackColor(r, g, b, a));
+						SDL_RenderDrawPoint(renderer, x + offset.x, y + offset.y);
+						stats.SDLCalls++;
+					} else {
+						// Copy a pixel from the source texture to the target pixel. This
+						// effectively does nearest neighbor sampling. Could probably be
+						// extended to copy from a larger rect to do bilinear sampling if
+						// needed.
+						int u, v;
+						InterpolateTexel(setup, w1, w2, w3, u, v);
+						state.SetTextureMods(texture, PackColor(r, g, b, a));
+						SDL_Rect srcrect;
+						srcrect.x = u;
+						srcrect.y = v;
+						srcrect.w = 1;
+						srcrect.h = 1;
+						SDL_Rect destrect;
+						destrect.x = x + offset.x;
+						destrect.y = y + offset.y;
+						destrect.w = 1;
+						destrect.h = 1;
+						SDL_RenderCopy(renderer, texture, &srcrect, &destrect);
+						stats.SDLCalls++;
+					}
+				}
+			});
+
+			if (isUniformColor) {
+				SDL_RenderFillRects(renderer, rectsbuffer, rects_i);
+				stats.SDLCalls++;
+			}
+
+			return pixels;
+		}
+
+		// Rasterizes a triangle into a CPU pixel buffer, without any calls to SDL. Textured triangles sample the CPU copy of their texture. Pixels are
+		// overwritten, not blended, the same as when the device draws triangles into the triangle cache. Returns the number of pixels that were written.
+		size_t RasterizeTriangle(const ImDrawVert& v1, const ImDrawVert& v2, const ImDrawVert& v3, const PixelSource* texture, const PixelBuffer& target)
+		{
+			// Pixels outside of the buffer are skipped before the rows are even walked, so that a huge triangle that only partly covers the buffer
+			// costs as much as the part that it covers.
+			TriangleSetup setup;
+			if (!SetupTriangle(v1, v2, v3, texture ? texture->Width : 0, texture ? texture->Height : 0, setup)) return 0;
+			if (!ClipTriangle(setup, SDL_Rect{ 0, 0, target.Width, target.Height })) return 0;
+
+			size_t pixels = 0;
+			ForEachSpan(setup, [&](int y, int start, int end, Sint32 w1, Sint32 w2, Sint32 w3) {
+				pixels += end - start;
+
+				ImU32* row = target.Pixels + y * target.Pitch;
+				if (!texture && setup.IsUniformColor)
+				{
+					std::fill(row + start, row + end, setup.UniformColor);
+					return;
+				}
+
+				if (start < end) GetRasterKernel().ShadeSpan(setup, w1, w2, w3, end - start, texture, row + start);
+			});
+			return pixels;
+		}
+
+		// Fills a convex polygon with a single color, a scanline at a time. The points are every stride-th vertex. Pixels are covered if their center is
+		// inside, and overwritten instead of blended, the same as by RasterizeTriangle. Returns the number of pixels that were written.
+		size_t FillConvexPolygon(const ImDrawVert* vertices, unsigned int points, unsigned int stride, ImU32 color, const PixelBuffer& target)
+		{
+			float minY = FLT_MAX, maxY = -FLT_MAX;
+			for (unsigned int i = 0; i < points; i++)
+			{
+				minY = std::min(minY, vertices[i * stride].pos.y);
+				maxY = std::max(maxY, vertices[i * stride].pos.y);
+			}
+
+			size_t pixels = 0;
+			const int firstRow = std::max(static_cast<int>(SDL_ceil(minY - 0.5f)), 0);
+			const int lastRow = std::min(static_cast<int>(SDL_ceil(maxY - 0.5f)), target.Height);
+			for (int y = firstRow; y < lastRow; y++)
+			{
+				// A convex polygon crosses every scanline at most twice, the span is between the leftmost and the rightmost crossing.
+				const float center = y + 0.5f;
+				float left = FLT_MAX, right = -FLT_MAX;
+				for (unsigned int i0 = points - 1, i1 = 0; i1 < points; i0 = i1++)
+				{
+					const ImVec2& a = vertices[i0 * stride].pos;
+					const ImVec2& b = vertices[i1 * stride].pos;
+					if ((a.y <= center) == (b.y <= center)) continue;
+
+					const float x = a.x + (center - a.y) * (b.x - a.x) / (b.y - a.y);
+					left = std::min(left, x);
+					right = std::max(right, x);
+				}
+
+				const int start = std::max(static_cast<int>(SDL_ceil(left - 0.5f)), 0);
+				const int end = std::min(static_cast<int>(SDL_ceil(right - 0.5f)), target.Width);
+				if (left > right || start >= end) continue;
+
+				std::fill(target.Pixels + y * target.Pitch + start, target.Pixels + y * target.Pitch + end, color);
+				pixels += end - start;
+			}
+			return pixels;
+		}
+
+		void FrameRasterizer::Begin(int width, int height)
+		{
+			if (width != Width || height != Height)
+			{
+				Width = std::max(width, 0);
+				Height = std::max(height, 0);
+				Columns = (Width + TileSize - 1) / TileSize;
+				Rows = (Height + TileSize - 1) / TileSize;
+				Pixels.assign(static_cast<size_t>(Width) * Height, 0);
+				Bins.resize(static_cast<size_t>(Columns) * Rows);
+			}
+
+			Primitives.clear();
+			for (auto& bin : Bins) bin.clear();
+			Dirty = { 0, 0, 0, 0 };
+			RasterizedPixels = 0;
+		}
+
+		void FrameRasterizer::AddCommand(const ImDrawVert* vertices, const ImDrawIdx* indices, unsigned int indexCount, const PixelSource* texture, const ImVec2& whitePixel,
+			const SDL_Rect& clip)
+		{
+			const SDL_Rect frame = { 0, 0, Width, Height };
+			SDL_Rect clipped;
+			if (!SDL_IntersectRect(&clip, &frame, &clipped)) return;
+
+			for (unsigned int i = 0; i + 3 <= indexCount; i += 3)
+			{
+				Primitive primitive;
+
+				SDL_Rect solidRect;
+				if (i + 6 <= indexCount && GetSolidRect(vertices, indices + i, whitePixel, solidRect, primitive.Color))
+				{
+					primitive.IsRect = true;
+					primitive.Texture = nullptr;
+					if (SDL_IntersectRect(&solidRect, &clipped, &primitive.Bounds)) Add(primitive);
+					i += 3;
+					continue;
+				}
+
+				ImDrawVert v0 = vertices[indices[i + 0]];
+				ImDrawVert v1 = vertices[indices[i + 1]];
+				ImDrawVert v2 = vertices[indices[i + 2]];
+
+				// Triangles are set up relative to their bounding box, the same as for the triangle cache, so that both round the same way.
+				const Rect bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+				const int offsetX = static_cast<int>(bounding.MinX), offsetY = static_cast<int>(bounding.MinY);
+				v0.pos.x -= offsetX; v0.pos.y -= offsetY;
+				v1.pos.x -= offsetX; v1.pos.y -= offsetY;
+				v2.pos.x -= offsetX; v2.pos.y -= offsetY;
+
+				primitive.IsRect = false;
+				primitive.Texture = bounding.UsesOnlyColor(whitePixel) ? nullptr : texture;
+				TriangleSetup& setup = primitive.Setup;
+				if (!SetupTriangle(v0, v1, v2, primitive.Texture ? primitive.Texture->Width : 0, primitive.Texture ? primitive.Texture->Height : 0, setup)) continue;
+
+				setup.MinX += offsetX; setup.MaxX += offsetX;
+				setup.MinY += offsetY; setup.MaxY += offsetY;
+
+				const SDL_Rect covered = { setup.MinX, setup.MinY, setup.MaxX - setup.MinX + 1, setup.MaxY - setup.MinY + 1 };
+				if (SDL_IntersectRect(&covered, &clipped, &primitive.Bounds)) Add(primitive);
+			}
+		}
+
+		void FrameRasterizer::Add(const Primitive& primitive)
+		{
+			const Uint32 index = static_cast<Uint32>(Primitives.size());
+			Primitives.push_back(primitive);
+
+			const SDL_Rect& bounds = primitive.Bounds;
+			for (int row = bounds.y / TileSize; row <= (bounds.y + bounds.h - 1) / TileSize; row++)
+			{
+				for (int column = bounds.x / TileSize; column <= (bounds.x + bounds.w - 1) / TileSize; column++)
+				{
+					Bins[row * Columns + column].push_back(index);
+				}
+			}
+
+			if (index == 0) Dirty = bounds;
+			else SDL_UnionRect(&Dirty, &bounds, &Dirty);
+		}
+
+		SDL_Rect FrameRasterizer::Rasterize(WorkerPool& workers)
+		{
+			if (Primitives.empty()) return SDL_Rect{ 0, 0, 0, 0 };
+
+			// Only the tiles that overlap anything are touched.
+			const int firstColumn = Dirty.x / TileSize, lastColumn = (Dirty.x + Dirty.w - 1) / TileSize;
+			const int firstRow = Dirty.y / TileSize, lastRow = (Dirty.y + Dirty.h - 1) / TileSize;
+			const int columns = lastColumn - firstColumn + 1;
+
+			workers.Run(columns * (lastRow - firstRow + 1), [&](int job) {
+				RasterizeTile((firstRow + job / columns) * Columns + firstColumn + job % columns);
+			});
+			return Dirty;
+		}
+
+		void FrameRasterizer::RasterizeTile(int tile)
+		{
+			const SDL_Rect bounds = { (tile % Columns) * TileSize, (tile / Columns) * TileSize, TileSize, TileSize };
+			SDL_Rect area;
+			if (!SDL_IntersectRect(&bounds, &Dirty, &area)) return;
+
+			for (int y = area.y; y < area.y + area.h; y++)
+			{
+				std::fill_n(&Pixels[y * Width + area.x], area.w, 0);
+			}
+
+			ImU32 span[TileSize];
+			size_t pixels = 0;
+			for (const Uint32 index : Bins[tile])
+			{
+				const Primitive& primitive = Primitives[index];
+				SDL_Rect clip;
+				if (!SDL_IntersectRect(&primitive.Bounds, &area, &clip)) continue;
+
+				if (primitive.IsRect)
+				{
+					for (int y = clip.y; y < clip.y + clip.h; y++)
+					{
+						ImU32* row = &Pixels[y * Width];
+						for (int x = clip.x; x < clip.x + clip.w; x++) row[x] = BlendOver(row[x], primitive.Color);
+					}
+					pixels += static_cast<size_t>(clip.w) * clip.h;
+					continue;
+				}
+
+				TriangleSetup setup = primitive.Setup;
+				if (!ClipTriangle(setup, clip)) continue;
+
+				const bool isUniformColor = !primitive.Texture && setup.IsUniformColor;
+				ForEachSpan(setup, [&](int y, int start, int end, Sint32 w1, Sint32 w2, Sint32 w3) {
+					ImU32* row = &Pixels[y * Width];
+					pixels += end - start;
+					if (isUniformColor)
+					{
+						for (int x = start; x < end; x++) row[x] = BlendOver(row[x], setup.UniformColor);
+						return;
+					}
+
+					GetRasterKernel().ShadeSpan(setup, w1, w2, w3, end - start, primitive.Texture, span);
+					for (int x = start; x < end; x++) row[x] = BlendOver(row[x], span[x - start]);
+				});
+			}
+
+			RasterizedPixels += pixels;
+		}
+	}
+}
+
+namespace ImGuiSDL
 {
-	struct Device* CurrentDevice = nullptr;
+	using namespace Internal;
+
+	// Everything a renderer needs lives in its context, so contexts of different renderers don't share any state and can be used from different
+	// threads.
+	struct Context : Device
+	{
+		explicit Context(SDL_Renderer* renderer) : Device(renderer) {}
+	};
+
+	// The context used by the functions that don't take one, which is the one set up by Initialize.
+	static Context* DefaultContext = nullptr;
+
+	static int ImGuiSDLEventWatch(void *userdata, SDL_Event *event) {
+		if (event->type == SDL_RENDER_TARGETS_RESET) {
+			// The event doesn't tell which renderer lost its targets, so every context starts over.
+			static_cast<Context*>(userdata)->CacheWasInvalidated = true;
+		}
+		return 0;
+	}
+
+	// Sets up a context with the given font texture. The pixels are four bytes each, in RGBA order.
+	static Context* MakeContext(SDL_Renderer* renderer, SDL_Texture* fontTexture, bool ownsFontTexture, const unsigned char* pixels, int width, int height,
+		const ImVec2& whitePixel)
+	{
+		Context* context = new Context(renderer);
+		context->FontTexture = fontTexture;
+		context->OwnsFontTexture = ownsFontTexture;
+		context->WhitePixel = whitePixel;
+
+		// Keeps a copy of the font pixels around for the CPU rasterizer.
+		context->FontPixels.Width = width;
+		context->FontPixels.Height = height;
+		context->FontPixels.Pixels.resize(static_cast<size_t>(width) * height);
+		context->CopyFontPixels(pixels, SDL_Rect{ 0, 0, width, height });
+		SDL_AddEventWatch(ImGuiSDLEventWatch, context);
+		return context;
+	}
+
+	// Creates a texture from the pixels of the ImGui font atlas, which are four bytes each, in RGBA order.
+	static SDL_Texture* CreateFontTexture(SDL_Renderer* renderer, unsigned char* pixels, int width, int height)
+	{
+		static constexpr uint32_t rmask = 0x000000ff, gmask = 0x0000ff00, bmask = 0x00ff0000, amask = 0xff000000;
+		SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels, width, height, 32, 4 * width, rmask, gmask, bmask, amask);
+		SDL_Texture* fontTexture = SDL_CreateTextureFromSurface(renderer, surface);
+		SDL_FreeSurface(surface);
+		return fontTexture;
+	}
+
+	Context* CreateContext(SDL_Renderer* renderer)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+
+		// Loads the font texture.
+		unsigned char* pixels;
+		int width, height;
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+		SDL_Texture* fontTexture = CreateFontTexture(renderer, pixels, width, height);
+
+		// No context names the font after its own texture, so the ID stays valid no matter which contexts are destroyed.
+		io.Fonts->TexID = static_cast<ImTextureID>(&FontTextureSentinel);
+
+		return MakeContext(renderer, fontTexture, true, pixels, width, height, io.Fonts->TexUvWhitePixel);
+	}
+
+	void DestroyContext(Context* context)
+	{
+		if (!context) return;
+
+		// Also frees up the memory of the font texture.
+		SDL_DelEventWatch(ImGuiSDLEventWatch, context);
+		delete context;
+	}
+
+	bool UpdateFontTexture(Context* context, int x, int y, int width, int height)
+	{
+		Device& device = *context;
+		if (!device.OwnsFontTexture) return false;
+
+		// Frames that are still being rasterized sample the font pixels.
+		device.Async.Wait();
+
+		ImGuiIO& io = ImGui::GetIO();
+		unsigned char* pixels;
+		int atlasWidth, atlasHeight;
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &atlasWidth, &atlasHeight);
+
+		// A texture can't change its size, so the font texture of a rebuilt atlas is created again.
+		if (atlasWidth != device.FontPixels.Width || atlasHeight != device.FontPixels.Height)
+		{
+			SDL_Texture* fontTexture = CreateFontTexture(device.Renderer, pixels, atlasWidth, atlasHeight);
+			if (!fontTexture) return false;
+
+			SDL_Texture* previousTexture = device.FontTexture;
+			device.FontTexture = fontTexture;
+			device.WhitePixel = io.Fonts->TexUvWhitePixel;
+
+			device.FontPixels.Width = atlasWidth;
+			device.FontPixels.Height = atlasHeight;
+			device.FontPixels.Pixels.resize(static_cast<size_t>(atlasWidth) * atlasHeight);
+			device.CopyFontPixels(pixels, SDL_Rect{ 0, 0, atlasWidth, atlasHeight });
+
+			device.InvalidateTexture(previousTexture);
+			SDL_DestroyTexture(previousTexture);
+		}
+		else
+		{
+			const SDL_Rect atlas = { 0, 0, atlasWidth, atlasHeight };
+			const SDL_Rect changed = { x, y, width, height };
+			SDL_Rect region;
+			if (!SDL_IntersectRect(&atlas, &changed, &region)) return true;
+
+			device.CopyFontPixels(pixels, region);
+
+			// The texture format is picked by SDL when it's created, so the region is converted from the CPU copy first.
+			Uint32 format;
+			SDL_QueryTexture(device.FontTexture, &format, nullptr, nullptr, nullptr);
+			device.RasterBuffer.resize(static_cast<size_t>(region.w) * region.h);
+			const ImU32* source = device.FontPixels.Pixels.data() + static_cast<size_t>(region.y) * atlasWidth + region.x;
+			SDL_ConvertPixels(region.w, region.h, SDL_PIXELFORMAT_ABGR8888, source, atlasWidth * static_cast<int>(sizeof(ImU32)),
+				format, device.RasterBuffer.data(), region.w * static_cast<int>(sizeof(ImU32)));
+			SDL_UpdateTexture(device.FontTexture, &region, device.RasterBuffer.data(), region.w * static_cast<int>(sizeof(ImU32)));
+			device.InvalidateTexture(device.FontTexture);
+		}
+
+		// Cached draw lists and the composite texture have glyphs drawn into them already.
+		device.ListCache.Reset();
+		device.Damage.Invalidate();
+		return true;
+	}
+
+	bool UpdateFontTexture(int x, int y, int width, int height)
+	{
+		return UpdateFontTexture(DefaultContext, x, y, width, height);
+	}
+
+	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight)
+	{
+		Initialize(renderer, windowWidth, windowHeight, Options());
+	}
+
+	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight, const Options& options)
+	{
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize.x = static_cast<float>(windowWidth);
+		io.DisplaySize.y = static_cast<float>(windowHeight);
+
+		if (options.SimplifyStyle)
+		{
+			ImGui::GetStyle().WindowRounding = 0.0f;
+			ImGui::GetStyle().AntiAliasedFill = false;
+			ImGui::GetStyle().AntiAliasedLines = false;
+			ImGui::GetStyle().ChildRounding = 0.0f;
+			ImGui::GetStyle().PopupRounding = 0.0f;
+			ImGui::GetStyle().FrameRounding = 0.0f;
+			ImGui::GetStyle().ScrollbarRounding = 0.0f;
+			ImGui::GetStyle().GrabRounding = 0.0f;
+			ImGui::GetStyle().TabRounding = 0.0f;
+		}
+
+		// Initializing again replaces the default context, which would leak its textures and threads otherwise.
+		DestroyContext(DefaultContext);
+		DefaultContext = CreateContext(renderer);
+		SetOptions(DefaultContext, options);
+	}
+
+	void Deinitialize()
+	{
+		DestroyContext(DefaultContext);
+		DefaultContext = nullptr;
+	}
+
+	void SetOptions(Context* context, const Options& options)
+	{
+		context->Options = options;
+	}
+
+	const Options& GetOptions(Context* context)
+	{
+		return context->Options;
+	}
+
+	const Stats& GetStats(Context* context)
+	{
+		return context->Stats;
+	}
+
+	void SetOptions(const Options& options) { SetOptions(DefaultContext, options); }
+	const Options& GetOptions() { return GetOptions(DefaultContext); }
+	const Stats& GetStats() { return GetStats(DefaultContext); }
+
+	void ShowStatsWindow(Context* context, bool* open)
+	{
+		if (!ImGui::Begin("ImGuiSDL Stats", open, ImGuiWindowFlags_AlwaysAutoResize))
+		{
+			ImGui::End();
+			return;
+		}
+
+		const Stats& stats = context->Stats;
+		const int historySize = static_cast<int>(context->TimeHistory.size());
+
+		char overlay[64];
+		SDL_snprintf(overlay, sizeof(overlay), "%.2f ms", stats.TotalTime);
+		ImGui::PlotLines("Frame time", context->TimeHistory.data(), historySize, context->HistoryOffset, overlay, 0.0f, FLT_MAX, ImVec2(240, 60));
+		ImGui::Text("Traversal %.2f ms, rasterization %.2f ms (%.2f ms cache fill), copy %.2f ms, cleanup %.2f ms",
+			stats.TraversalTime, stats.RasterizationTime, stats.CacheFillTime, stats.CopyTime, stats.CleanupTime);
+
+		ImGui::Separator();
+		const size_t lookups = stats.TriangleCacheHits + stats.TriangleCacheMisses;
+		SDL_snprintf(overlay, sizeof(overlay), "%.1f %%", lookups > 0 ? static_cast<double>(stats.TriangleCacheHits) / lookups * 100.0 : 100.0);
+		ImGui::PlotLines("Cache hit rate", context->HitRateHistory.data(), historySize, context->HistoryOffset, overlay, 0.0f, 100.0f, ImVec2(240, 60));
+		ImGui::Text("Triangles: %u submitted, %u culled", static_cast<unsigned int>(stats.TrianglesSubmitted), static_cast<unsigned int>(stats.TrianglesCulled));
+		ImGui::Text("Cache: %u hits, %u misses, %u evictions", static_cast<unsigned int>(stats.TriangleCacheHits),
+			static_cast<unsigned int>(stats.TriangleCacheMisses), static_cast<unsigned int>(stats.TriangleCacheEvictions));
+		ImGui::Text("Deferred: %u triangles, about %u degraded frames left", static_cast<unsigned int>(stats.TrianglesDeferred),
+			static_cast<unsigned int>(stats.DegradedFrames));
+		ImGui::Text("Cached: %u triangles, %u textures, %.1f MiB", static_cast<unsigned int>(stats.CachedTriangles),
+			static_cast<unsigned int>(stats.CachedTextures), stats.CachedTextureBytes / (1024.0 * 1024.0));
+		ImGui::Text("Pixels rasterized: %u, SDL calls: %u, batches: %u", static_cast<unsigned int>(stats.PixelsRasterized), static_cast<unsigned int>(stats.SDLCalls),
+			static_cast<unsigned int>(stats.DrawBatches));
+
+		ImGui::End();
+	}
+
+	void ShowStatsWindow(bool* open)
+	{
+		ShowStatsWindow(DefaultContext, open);
+	}
+
+	// Returns the pixels of a bounding box that are inside of the clip rect, or false if there are none. Cache items usually cover the whole
+	// bounding box, but an item that sticks out of its clip rect only covers the visible part, so that a huge triangle which is barely visible
+	// doesn't need a huge texture. Such items are only found again with the same visible part, so their size is part of their key.
+	static bool GetVisibleBounds(const Rect& bounding, const Device::ClipRect& clipRect, SDL_Rect& visible, bool& isCutOff)
+	{
+		const int minX = static_cast<int>(SDL_floor(bounding.MinX)), minY = static_cast<int>(SDL_floor(bounding.MinY));
+		const SDL_Rect bounds = { minX, minY,
+			std::max(static_cast<int>(SDL_ceil(bounding.MaxX)) - minX, 1),
+			std::max(static_cast<int>(SDL_ceil(bounding.MaxY)) - minY, 1) };
+		const SDL_Rect clip = { clipRect.X, clipRect.Y, clipRect.Width, clipRect.Height };
+		if (!SDL_IntersectRect(&bounds, &clip, &visible)) return false;
+
+		isCutOff = !SDL_RectEquals(&bounds, &visible);
+		return true;
+	}
+
+	// Draws a run of triangles (see GetTriangleRun), like a convex polygon that ImGui filled with a fan (see GetConvexFan) or an antialiased line,
+	// as a single cache item, so that it's rasterized once and drawn with one copy instead of one per triangle. Runs are keyed by their first three
+	// vertices, their number of points (of vertices for runs that aren't fans) and a hash of all of their vertices, and of their indices for runs
+	// that aren't fans. Returns false if the run can't be rasterized on the CPU, in which case its triangles have to be drawn one by one.
+	static bool RenderRun(Device& device, const ImDrawVert* vertexBuffer, const ImDrawIdx* indices, const TriangleRun& run, SDL_Texture* commandTexture,
+		const Device::ClipRect& clipRect)
+	{
+		ImGuiSDL::Stats& stats = device.Stats;
+		std::vector<ImDrawVert>& vertices = device.RunVertices;
+		vertices.assign(vertexBuffer + run.Base, vertexBuffer + run.Base + run.VertexCount);
+
+		// Other runs are rasterized through their indices, which are moved to the first vertex of the run so that they're the same wherever the
+		// run ends up in the vertex buffer.
+		std::vector<ImDrawIdx>& runIndices = device.RunIndices;
+		runIndices.clear();
+		if (!run.Fan)
+		{
+			for (unsigned int i = 0; i < run.IndexCount; i++) runIndices.push_back(static_cast<ImDrawIdx>(indices[i] - run.Base));
+		}
 
-	namespace TupleHash
-	{
-		template <typename T> struct Hash
+		Rect bounding = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (const ImDrawVert& vertex : vertices)
 		{
-			std::size_t operator()(const T& value) const
-			{
-				return std::hash<T>()(value);
-			}
-		};
+			bounding.MinX = std::min(bounding.MinX, vertex.pos.x);
+			bounding.MinY = std::min(bounding.MinY, vertex.pos.y);
+			bounding.MaxX = std::max(bounding.MaxX, vertex.pos.x);
+			bounding.MaxY = std::max(bounding.MaxY, vertex.pos.y);
+			bounding.MinU = std::min(bounding.MinU, vertex.uv.x);
+			bounding.MinV = std::min(bounding.MinV, vertex.uv.y);
+			bounding.MaxU = std::max(bounding.MaxU, vertex.uv.x);
+			bounding.MaxV = std::max(bounding.MaxV, vertex.uv.y);
+		}
 
-		template <typename T> void CombineHash(std::size_t& seed, const T& value)
+		SDL_Texture* texture = bounding.UsesOnlyColor(device.WhitePixel) ? nullptr : commandTexture;
+		if (!device.CanRasterizeOnCPU(texture)) return false;
+
+		SDL_Rect visible;
+		bool isCutOff;
+		if (!GetVisibleBounds(bounding, clipRect, visible, isCutOff))
 		{
-			seed ^= TupleHash::Hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			stats.TrianglesCulled += run.IndexCount / 3;
+			return true;
 		}
 
-		template <typename Tuple, std::size_t Index = std::tuple_size<Tuple>::value - 1> struct Hasher
+		// Runs are cached relative to the pixel their visible bounding box starts in, the same as single triangles.
+		const SDL_Point origin = { visible.x, visible.y };
+		for (ImDrawVert& vertex : vertices)
 		{
-			static void Hash(std::size_t& seed, const Tuple& tuple)
-			{
-				Hasher<Tuple, Index - 1>::Hash(seed, tuple);
-				CombineHash(seed, std::get<Index>(tuple));
-			}
-		};
+			vertex.pos.x -= origin.x;
+			vertex.pos.y -= origin.y;
+		}
 
-		template <typename Tuple> struct Hasher<Tuple, 0>
+		// Normalized runs are snapped to the subpixel grid, and cached in white if all of their vertices only differ in alpha.
+		ImU32 tint = 0xffffffff;
+		if (device.Options.NormalizeTriangleKeys)
 		{
-			static void Hash(std::size_t& seed, const Tuple& tuple)
+			const float steps = static_cast<float>(std::max(device.Options.TriangleCacheSubpixels, 1));
+			for (ImDrawVert& vertex : vertices)
 			{
-				CombineHash(seed, std::get<0>(tuple));
+				vertex.pos.x = SDL_floor(vertex.pos.x * steps + 0.5f) / steps;
+				vertex.pos.y = SDL_floor(vertex.pos.y * steps + 0.5f) / steps;
 			}
-		};
 
-		template <typename... T> struct Hash<std::tuple<T...>>
-		{
-			std::size_t operator()(const std::tuple<T...>& value) const
+			const ImU32 color = vertices[0].col;
+			const ImU32 transparent = color & ~IM_COL32_A_MASK;
+			bool canTint = true;
+			for (const ImDrawVert& vertex : vertices) canTint = canTint && (vertex.col == color || vertex.col == transparent);
+			if (canTint)
 			{
-				std::size_t seed = 0;
-				Hasher<std::tuple<T...>>::Hash(seed, value);
-				return seed;
+				tint = color;
+				for (ImDrawVert& vertex : vertices) vertex.col = vertex.col == color ? 0xffffffff : 0x00ffffff;
 			}
-		};
-	}
+		}
 
-	template <typename Key, typename Value> class LRUCache
-	{
-	public:
-		void SetCapacity(size_t capacity) { Capacity = capacity; }
+		const ImDrawVert& v0 = vertices[indices[0] - run.Base];
+		const ImDrawVert& v1 = vertices[indices[1] - run.Base];
+		const ImDrawVert& v2 = vertices[indices[2] - run.Base];
+		const Uint64 seed = run.Fan ? (run.Fan->Antialiased ? 1 : 0) : HashBytes(runIndices.data(), runIndices.size() * sizeof(ImDrawIdx), 2);
+		const Uint64 hash = HashBytes(vertices.data(), vertices.size() * sizeof(ImDrawVert), seed);
+		const Device::TriangleKey key = { texture, {
+			{ v0.pos.x, v0.pos.y, v0.uv.x, v0.uv.y, v0.col },
+			{ v1.pos.x, v1.pos.y, v1.uv.x, v1.uv.y, v1.col },
+			{ v2.pos.x, v2.pos.y, v2.uv.x, v2.uv.y, v2.col } },
+			run.Fan ? run.Fan->Points : run.VertexCount, { static_cast<Uint32>(hash), static_cast<Uint32>(hash >> 32) },
+			{ isCutOff ? static_cast<Uint32>(visible.w) : 0u, isCutOff ? static_cast<Uint32>(visible.h) : 0u } };
+
+		if (const auto* found = device.TriangleCache.TryGet(key))
+		{
+			const auto& cached = *found;
+			device.CopyCacheItem(*cached, { origin.x, origin.y, cached->Width, cached->Height }, tint);
+			stats.TriangleCacheHits++;
+			return true;
+		}
 
-		bool Contains(const Key& key) const
+		// Once the cache fill budget is used up, an untextured run is drawn without the cache, and cached as a whole in a later frame. Textured
+		// ones are still cached right away, the same as textured triangles.
+		if (!texture && device.IsCacheFillOverBudget())
 		{
-			return Container.find(key) != Container.end();
+			const SDL_Rect clip = { clipRect.X, clipRect.Y, clipRect.Width, clipRect.Height };
+			device.DrawDeferredRun(vertexBuffer, indices, run.IndexCount, clip);
+			return true;
 		}
 
-		const Value& At(const Key& key)
+		// The item covers every pixel whose center can be inside of one of the triangles, or only the visible ones of those.
+		float maxX = 0.0f, maxY = 0.0f;
+		for (const ImDrawVert& vertex : vertices)
 		{
-			assert(Contains(key));
+			maxX = std::max(maxX, vertex.pos.x);
+			maxY = std::max(maxY, vertex.pos.y);
+		}
+
+		auto cached = std::make_unique<Device::TriangleCacheItem>();
+		cached->Width = isCutOff ? visible.w : std::max(static_cast<int>(SDL_ceil(maxX)), 1);
+		cached->Height = isCutOff ? visible.h : std::max(static_cast<int>(SDL_ceil(maxY)), 1);
 
-			const auto location = Container.find(key);
-			Order.splice(Order.begin(), Order, location->second);
-			return location->second->second;
+		{
+			ScopedTimer timer(stats.RasterizationTime), fillTimer(stats.CacheFillTime);
+			device.AllocateCacheItem(*cached, true);
+			if (run.Fan) device.RasterizeFanItem(*cached, vertices, run.Fan->Points, run.Fan->Antialiased, texture);
+			else device.RasterizeRunItem(*cached, vertices, runIndices, texture);
 		}
 
-		void Insert(const Key& key, Value value)
+		device.CopyCacheItem(*cached, { origin.x, origin.y, cached->Width, cached->Height }, tint);
+		stats.TriangleCacheMisses++;
+
+		device.InsertCacheItem(key, std::move(cached));
+		return true;
+	}
+
+	// Draws a single draw command, clipped to the given rectangle. Commands that the frame rasterizer can handle are only binned here.
+	static void RenderCommand(Device& device, const ImDrawList* commandList, const ImDrawCmd* drawCommand, const ImDrawVert* vertexBuffer, const ImDrawIdx* indexBuffer,
+		const Device::ClipRect& clipRect, SDL_Texture* renderTarget, bool rasterizeFrame)
+	{
+		ImGuiSDL::Stats& stats = device.Stats;
+		device.SetClipRect(clipRect);
+		if (!drawCommand->UserCallback) stats.TrianglesSubmitted += drawCommand->ElemCount / 3;
+
+		SDL_Texture* commandTexture = IsFontTexture(drawCommand->TextureId) ? device.FontTexture : static_cast<SDL_Texture*>(drawCommand->TextureId);
+		const bool isBinned = rasterizeFrame && !drawCommand->UserCallback && device.CanRasterizeFrame(commandTexture);
+		if (!isBinned) device.FlushFrame();
+
+		if (drawCommand->UserCallback)
+		{
+			// Callbacks get the textures with the mods they set themselves, and the blend mode that the rest of ImGui is drawn with.
+			device.State.RestoreTextureMods();
+			device.State.SetBlendMode(SDL_BLENDMODE_BLEND);
+			drawCommand->UserCallback(commandList, drawCommand);
+			device.State.Refresh();
+		}
+		else if (isBinned)
+		{
+			const SDL_Rect clip = { clipRect.X, clipRect.Y, clipRect.Width, clipRect.Height };
+			device.Frame.AddCommand(vertexBuffer, indexBuffer, drawCommand->ElemCount, commandTexture ? &device.FontPixels : nullptr, device.WhitePixel, clip);
+		}
+		else if (device.UsesRenderGeometry() && device.DrawGeometry(vertexBuffer, commandList->VtxBuffer.Size,
+			indexBuffer, static_cast<int>(drawCommand->ElemCount), commandTexture))
+		{
+			// Everything was drawn by SDL already.
+		}
+		else
 		{
-			const auto existingLocation = Container.find(key);
-			if (existingLocation != Container.end())
+			int textureWidth = 0, textureHeight = 0;
+			if (commandTexture) SDL_QueryTexture(commandTexture, nullptr, nullptr, &textureWidth, &textureHeight);
+
+			// Shapes that are outside of the clip rect, like the rows of a long list that are scrolled out of view, are skipped before they're
+			// batched or cached.
+			const SDL_Rect clip = { clipRect.X, clipRect.Y, clipRect.Width, clipRect.Height };
+
+			// Loops over triangles.
+			for (unsigned int i = 0; i + 3 <= drawCommand->ElemCount; i += 3)
 			{
-				Order.erase(existingLocation->second);
-				Container.erase(existingLocation);
+				// Rounded rectangles are filled with rectangles and corner sprites, instead of caching every triangle of their fan and fringe.
+				ConvexFan fan;
+				SDL_Rect roundedRect;
+				float radii[4];
+				ImU32 roundedColor;
+				if (GetConvexFan(indexBuffer + i, drawCommand->ElemCount - i, fan) && fan.Points > 4
+					&& GetRoundedRect(vertexBuffer, fan, device.WhitePixel, roundedRect, radii, roundedColor))
+				{
+					const bool isVisible = SDL_HasIntersection(&roundedRect, &clip) == SDL_TRUE;
+					if (!isVisible || device.FillRoundedRect(roundedRect, radii, roundedColor, fan.Antialiased))
+					{
+						if (!isVisible) stats.TrianglesCulled += fan.IndexCount / 3;
+						i += fan.IndexCount - 3;
+						continue;
+					}
+				}
+
+				// Solid rectangles don't need the triangle cache at all, they are batched into rectangle fills instead.
+				SDL_Rect solidRect;
+				ImU32 solidColor;
+				if (i + 6 <= drawCommand->ElemCount && GetSolidRect(vertexBuffer, indexBuffer + i, device.WhitePixel, solidRect, solidColor))
+				{
+					if (SDL_HasIntersection(&solidRect, &clip)) device.FillRect(solidRect, solidColor);
+					else stats.TrianglesCulled += 2;
+					i += 3;
+					continue;
+				}
+
+				// Glyphs and images are copied straight from their texture, which doesn't need the triangle cache either.
+				SDL_Rect source, destination;
+				SDL_RendererFlip flip;
+				ImU32 quadColor;
+				if (commandTexture && i + 6 <= drawCommand->ElemCount
+					&& GetTexturedRect(vertexBuffer, indexBuffer + i, textureWidth, textureHeight, source, destination, flip, quadColor))
+				{
+					if (SDL_HasIntersection(&destination, &clip)) device.CopyQuad(commandTexture, source, destination, flip, quadColor);
+					else stats.TrianglesCulled += 2;
+					i += 3;
+					continue;
+				}
+
+				// Any other convex polygon is cached as a whole, so that it takes one copy instead of one for every triangle of its fan and fringe. So
+				// are other shapes of more than a couple of triangles, mostly antialiased lines, which would otherwise cache every triangle of their fringe.
+				TriangleRun run;
+				const bool isFan = GetConvexFan(indexBuffer + i, drawCommand->ElemCount - i, fan);
+				if (isFan) run = TriangleRun{ fan.Base, fan.Points * (fan.Antialiased ? 2 : 1), fan.IndexCount, &fan };
+				if ((isFan || GetTriangleRun(indexBuffer + i, drawCommand->ElemCount - i, run))
+					&& RenderRun(device, vertexBuffer, indexBuffer + i, run, commandTexture, clipRect))
+				{
+					i += run.IndexCount - 3;
+					continue;
+				}
+
+				ImDrawVert v0 = vertexBuffer[indexBuffer[i + 0]];
+				ImDrawVert v1 = vertexBuffer[indexBuffer[i + 1]];
+				ImDrawVert v2 = vertexBuffer[indexBuffer[i + 2]];
+
+				const Rect bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+				const bool isTriangleUniformColor = v0.col == v1.col && v1.col == v2.col;
+				const bool doesTriangleUseOnlyColor = bounding.UsesOnlyColor(device.WhitePixel);
+
+				SDL_Rect visible;
+				bool isCutOff;
+				if (!GetVisibleBounds(bounding, clipRect, visible, isCutOff))
+				{
+					// Not in clip rect, ignore
+					stats.TrianglesCulled++;
+					continue;
+				}
+
+				SDL_Texture *texture = doesTriangleUseOnlyColor ? nullptr : commandTexture;
+
+				// Triangles are cached relative to the pixel their visible bounding box starts in.
+				const SDL_Point origin = { visible.x, visible.y };
+				ImDrawVert* const vertices[] = { &v0, &v1, &v2 };
+				for (ImDrawVert* vertex : vertices)
+				{
+					vertex->pos.x -= origin.x;
+					vertex->pos.y -= origin.y;
+				}
+
+				// Normalized triangles are cached in white and then tinted with their actual color, and are snapped to the subpixel grid.
+				ImU32 tint = 0xffffffff;
+				if (device.Options.NormalizeTriangleKeys)
+				{
+					const float steps = static_cast<float>(std::max(device.Options.TriangleCacheSubpixels, 1));
+					for (ImDrawVert* vertex : vertices)
+					{
+						vertex->pos.x = SDL_floor(vertex->pos.x * steps + 0.5f) / steps;
+						vertex->pos.y = SDL_floor(vertex->pos.y * steps + 0.5f) / steps;
+					}
+
+					if (isTriangleUniformColor)
+					{
+						tint = v0.col;
+						v0.col = v1.col = v2.col = 0xffffffff;
+					}
+				}
+
+				// First we check if there is a cached version of this triangle already waiting for us. If so, we can just do a super fast texture copy.
+
+				const Device::TriangleKey key = { texture, {
+					{ v0.pos.x, v0.pos.y, v0.uv.x, v0.uv.y, v0.col },
+					{ v1.pos.x, v1.pos.y, v1.uv.x, v1.uv.y, v1.col },
+					{ v2.pos.x, v2.pos.y, v2.uv.x, v2.uv.y, v2.col } }, 0, { 0, 0 },
+					{ isCutOff ? static_cast<Uint32>(visible.w) : 0u, isCutOff ? static_cast<Uint32>(visible.h) : 0u } };
+
+				if (const auto* found = device.TriangleCache.TryGet(key)) {
+					const auto& cached = *found;
+					const SDL_Rect destination = { origin.x, origin.y, cached->Width, cached->Height };
+					device.CopyCacheItem(*cached, destination, tint);
+					stats.TriangleCacheHits++;
+				} else if (!texture && device.IsCacheFillOverBudget()) {
+					device.DrawDeferredTriangle(vertexBuffer[indexBuffer[i + 0]], vertexBuffer[indexBuffer[i + 1]], vertexBuffer[indexBuffer[i + 2]], clip);
+				} else {
+					// The item covers every pixel whose center can be inside of the triangle, or only the visible ones of those.
+					auto cached = std::make_unique<Device::TriangleCacheItem>();
+					cached->Width = isCutOff ? visible.w : std::max(static_cast<int>(SDL_ceil(SDL_max(v0.pos.x, SDL_max(v1.pos.x, v2.pos.x)))), 1);
+					cached->Height = isCutOff ? visible.h : std::max(static_cast<int>(SDL_ceil(SDL_max(v0.pos.y, SDL_max(v1.pos.y, v2.pos.y)))), 1);
+
+					{
+						ScopedTimer timer(stats.RasterizationTime), fillTimer(stats.CacheFillTime);
+						const bool rasterizeOnCPU = device.CanRasterizeOnCPU(texture);
+						device.AllocateCacheItem(*cached, rasterizeOnCPU);
+						if (rasterizeOnCPU) device.RasterizeCacheItem(*cached, v0, v1, v2, texture);
+						else device.RenderCacheItem(*cached, v0, v1, v2, texture, renderTarget);
+					}
+
+					const SDL_Rect destination = { origin.x, origin.y, cached->Width, cached->Height };
+					device.CopyCacheItem(*cached, destination, tint);
+					stats.TriangleCacheMisses++;
+
+					device.InsertCacheItem(key, std::move(cached));
+				}
 			}
 
-			Order.push_front(std::make_pair(key, std::move(value)));
-			Container.insert(std::make_pair(key, Order.begin()));
+			device.FlushBatches();
 		}
+	}
+
+	// Draws all commands of a draw list, clipped to each of the areas. The vertices can be a moved copy of the ones in the draw list, in which case
+	// the origin is where the copy was moved to.
+	static void RenderList(Device& device, const ImDrawList* commandList, const ImDrawVert* vertexBuffer, const std::vector<SDL_Rect>& areas, const SDL_Point& origin,
+		SDL_Texture* renderTarget, bool rasterizeFrame)
+	{
+		const ImDrawIdx* indexBuffer = commandList->IdxBuffer.Data;
 
-		void Reset()
+		for (int cmd_i = 0; cmd_i < commandList->CmdBuffer.Size; cmd_i++)
 		{
-			Order.clear();
-			Container.clear();
+			const ImDrawCmd* drawCommand = &commandList->CmdBuffer[cmd_i];
+
+			SDL_Rect commandClip = GetClipRect(drawCommand->ClipRect);
+			commandClip.x -= origin.x;
+			commandClip.y -= origin.y;
+
+			if (drawCommand->UserCallback)
+			{
+				// Callbacks are only called once, clipped to all the areas they overlap.
+				SDL_Rect bounds = { 0, 0, 0, 0 };
+				for (const SDL_Rect& area : areas)
+				{
+					SDL_Rect clip;
+					if (!SDL_IntersectRect(&commandClip, &area, &clip)) continue;
+					if (SDL_RectEmpty(&bounds)) bounds = clip;
+					else SDL_UnionRect(&bounds, &clip, &bounds);
+				}
+
+				const Device::ClipRect clipRect = { bounds.x, bounds.y, bounds.w, bounds.h };
+				if (!SDL_RectEmpty(&bounds)) RenderCommand(device, commandList, drawCommand, vertexBuffer, indexBuffer, clipRect, renderTarget, rasterizeFrame);
+			}
+			else
+			{
+				for (const SDL_Rect& area : areas)
+				{
+					SDL_Rect clip;
+					if (!SDL_IntersectRect(&commandClip, &area, &clip)) continue;
+
+					const Device::ClipRect clipRect = { clip.x, clip.y, clip.w, clip.h };
+					RenderCommand(device, commandList, drawCommand, vertexBuffer, indexBuffer, clipRect, renderTarget, rasterizeFrame);
+				}
+			}
+
+			indexBuffer += drawCommand->ElemCount;
 		}
+	}
 
-		void Clean()
+	// Returns false if none of the commands of a draw list are clipped to somewhere inside of the areas, in which case the whole list can be skipped
+	// without looking at its vertices. That's the case for windows that are off screen, or outside of the damaged areas.
+	static bool IsListVisible(const ImDrawList* commandList, const std::vector<SDL_Rect>& areas)
+	{
+		for (const ImDrawCmd& command : commandList->CmdBuffer)
 		{
-			while (Container.size() > Capacity)
+			const SDL_Rect commandClip = GetClipRect(command.ClipRect);
+			for (const SDL_Rect& area : areas)
 			{
-				auto last = Order.end();
-				last--;
-				Container.erase(last->first);
-				Order.pop_back();
+				if (SDL_HasIntersection(&commandClip, &area)) return true;
 			}
 		}
+		return false;
+	}
 
-	private:
-		size_t Capacity = 0;
-		std::list<std::pair<Key, Value>> Order;
-		std::unordered_map<Key, decltype(Order.begin()), TupleHash::Hash<Key>> Container;
-	};
-
-	struct Color
+	// Draws a draw list from the draw list cache, rendering it into a texture first if it looked the same in the previous frame. Returns false if
+	// the draw list has to be drawn as usual.
+	static bool RenderCachedList(Device& device, const ImDrawList* commandList, const std::vector<SDL_Rect>& areas, const SDL_Rect& screen, SDL_Texture* renderTarget,
+		bool rasterizeFrame)
 	{
-		const float R, G, B, A;
-
-		explicit Color(uint32_t color)
-			: R(((color >> 0) & 0xff) / 255.0f), G(((color >> 8) & 0xff) / 255.0f), B(((color >> 16) & 0xff) / 255.0f), A(((color >> 24) & 0xff) / 255.0f) { }
-		Color(float r, float g, float b, float a) : R(r), G(g), B(b), A(a) { }
+		SDL_Rect bounds;
+		Uint64 hash;
+		if (!device.ListCache.Prepare(*commandList, screen, bounds, hash)) return false;
 
-		Color operator*(const Color& c) const { return Color(R * c.R, G * c.G, B * c.B, A * c.A); }
-		Color operator*(float v) const { return Color(R * v, G * v, B * v, A * v); }
-		Color operator+(const Color& c) const { return Color(R + c.R, G + c.G, B + c.B, A + c.A); }
+		// Everything that was binned so far has to be drawn first, it's below this draw list.
+		device.FlushFrame();
 
-		uint32_t ToInt() const
+		const DrawListCache::Item* item = device.ListCache.Find(hash);
+		if (!item)
 		{
-			return	((static_cast<int>(R * 255) & 0xff) << 0)
-				  | ((static_cast<int>(G * 255) & 0xff) << 8)
-				  | ((static_cast<int>(B * 255) & 0xff) << 16)
-				  | ((static_cast<int>(A * 255) & 0xff) << 24);
+			const size_t bytes = static_cast<size_t>(bounds.w) * bounds.h * sizeof(ImU32);
+			if (!device.ListCache.WasSeenLastFrame(hash) || bytes > device.Options.DrawListCacheSize) return false;
+
+			auto rendered = std::make_unique<DrawListCache::Item>();
+			rendered->Texture = device.MakeLayerTexture(bounds.w, bounds.h);
+			rendered->Bytes = bytes;
+			if (!rendered->Texture) return false;
+
+			const std::vector<SDL_Rect> area = { SDL_Rect{ 0, 0, bounds.w, bounds.h } };
+			device.State.SetTarget(rendered->Texture);
+			device.ClearAreas(area);
+
+			if (rasterizeFrame) device.Frame.Begin(bounds.w, bounds.h);
+			RenderList(device, commandList, device.ListCache.GetVertices().data(), area, SDL_Point{ bounds.x, bounds.y }, rendered->Texture, rasterizeFrame);
+			device.FlushFrame();
+			if (rasterizeFrame) device.Frame.Begin(screen.w, screen.h);
+
+			device.State.SetTarget(renderTarget);
+
+			item = rendered.get();
+			device.ListCache.Insert(hash, std::move(rendered), device.Options.DrawListCacheSize);
 		}
 
-		void UseAsDrawColor(SDL_Renderer* renderer) const
+		ScopedTimer timer(device.Stats.CopyTime);
+		for (const SDL_Rect& area : areas)
 		{
-			SDL_SetRenderDrawColor(renderer,
-				static_cast<uint8_t>(R * 255),
-				static_cast<uint8_t>(G * 255),
-				static_cast<uint8_t>(B * 255),
-				static_cast<uint8_t>(A * 255));
+			SDL_Rect clip;
+			if (!SDL_IntersectRect(&bounds, &area, &clip)) continue;
+
+			device.SetClipRect(Device::ClipRect{ clip.x, clip.y, clip.w, clip.h });
+			SDL_RenderCopy(device.Renderer, item->Texture, nullptr, &bounds);
+			device.Stats.SDLCalls++;
 		}
-	};
+		return true;
+	}
 
-	struct Device
+	bool Render(Context* context, ImDrawData* drawData)
 	{
-		SDL_Renderer* Renderer;
-		bool CacheWasInvalidated = false;
+		Device& device = *context;
+
+		if (device.CacheWasInvalidated) {
+			device.CacheWasInvalidated = false;
+			device.ResetTriangleCache();
+			device.Damage.Invalidate();
+			device.ListCache.Reset();
+		}
+
+		device.Stats = Stats();
+		Stats& stats = device.Stats;
+		const Uint64 start = SDL_GetPerformanceCounter();
+
+		float initialScaleX, initialScaleY;
+		SDL_RenderGetScale(device.Renderer, &initialScaleX, &initialScaleY);
+		SDL_RenderSetScale(device.Renderer, 1.0f, 1.0f);
+
+		// Remembers the render target, clip rect, draw color and blend mode, which are all restored at the end.
+		device.State.Begin();
+		SDL_Texture* initialRenderTarget = device.State.GetTarget();
 
-		struct ClipRect
+		int targetWidth, targetHeight;
+		device.GetTargetSize(initialRenderTarget, targetWidth, targetHeight);
+
+		// The draw data is in points from its DisplayPos, which are FramebufferScale pixels each. With a RenderScale, everything is drawn into the
+		// composite texture at that fraction of the size of the render target, and the composite texture is then stretched onto the render target.
+		const float renderScale = device.Options.RenderScale > 0.0f ? device.Options.RenderScale : 1.0f;
+		const bool isScaled = renderScale != 1.0f;
+		const float framebufferScaleX = drawData->FramebufferScale.x > 0.0f ? drawData->FramebufferScale.x : 1.0f;
+		const float framebufferScaleY = drawData->FramebufferScale.y > 0.0f ? drawData->FramebufferScale.y : 1.0f;
+		const ImVec2 scale(framebufferScaleX * renderScale, framebufferScaleY * renderScale);
+
+		// When every command goes to SDL_RenderGeometry straight onto the window, SDL scales the draw data itself, instead of it being copied every
+		// frame. Nothing else may look at the positions then: not the composite texture, the frame rasterizer, or the draw list cache. The window
+		// keeps its scale while SDL draws into other targets, so commands that SDL_RenderGeometry fails to draw still end up in the right place.
+		const bool isScaledBySDL = (scale.x != 1.0f || scale.y != 1.0f) && !isScaled && !initialRenderTarget && device.UsesRenderGeometry()
+			&& !device.UsesFrameRasterizer() && !device.Options.RedrawDamagedRegions && !device.Options.CacheDrawLists
+			&& drawData->DisplayPos.x == 0.0f && drawData->DisplayPos.y == 0.0f;
+		if (isScaledBySDL)
 		{
-			int X, Y, Width, Height;
-		} Clip;
+			SDL_RenderSetScale(device.Renderer, scale.x, scale.y);
+			device.State.Refresh();
+			targetWidth = std::max(static_cast<int>(SDL_ceil(targetWidth / scale.x)), 1);
+			targetHeight = std::max(static_cast<int>(SDL_ceil(targetHeight / scale.y)), 1);
+		}
+		else drawData = device.ScaleDrawData(drawData, scale);
 
-		struct TriangleCacheItem
+		if (isScaled)
 		{
-			SDL_Texture* Texture = nullptr;
-			int Width = 0, Height = 0;
+			targetWidth = std::max(static_cast<int>(SDL_ceil(targetWidth * renderScale)), 1);
+			targetHeight = std::max(static_cast<int>(SDL_ceil(targetHeight * renderScale)), 1);
+		}
 
-			~TriangleCacheItem() { if (Texture) SDL_DestroyTexture(Texture); }
-		};
+		// Without damage tracking or a render scale, everything is drawn straight onto the render target.
+		SDL_Texture* renderTarget = initialRenderTarget;
+		std::vector<SDL_Rect>& areas = device.DrawAreas;
+		areas.assign(1, SDL_Rect{ 0, 0, targetWidth, targetHeight });
+		bool changed = true;
+
+		if (device.Options.RedrawDamagedRegions || isScaled)
+		{
+			if (!device.PrepareComposite(targetWidth, targetHeight)) device.Damage.Invalidate();
 
-		// The triangle cache has to be basically a full representation of the triangle.
-		// This includes the (offset) vertex positions, texture coordinates and vertex colors.
-		using GenericTriangleVertexKey = std::tuple<float, float, float, float, uint32_t>;
-		using GenericTriangleKey = std::tuple<GenericTriangleVertexKey, GenericTriangleVertexKey, GenericTriangleVertexKey, SDL_Texture*>;
+			// Without damage tracking the whole composite texture is drawn again, and the damage tracker has to start over once it's turned on.
+			if (device.Options.RedrawDamagedRegions)
+			{
+				changed = device.Damage.Update(drawData, targetWidth, targetHeight);
+				areas = device.Damage.GetRects();
+			}
+			else device.Damage.Invalidate();
+
+			renderTarget = device.CompositeTexture;
+			device.State.SetTarget(renderTarget);
+			if (!areas.empty()) device.ClearAreas(areas);
+		}
+		else if (device.CompositeTexture)
+		{
+			device.ReleaseComposite();
+		}
 
-		LRUCache<GenericTriangleKey, std::unique_ptr<TriangleCacheItem>> TriangleCache;
+		const bool rasterizeFrame = device.UsesFrameRasterizer();
+		if (rasterizeFrame) device.Frame.Begin(targetWidth, targetHeight);
 
-		Device(SDL_Renderer* renderer) : Renderer(renderer) { }
+		const SDL_Rect screen = { 0, 0, targetWidth, targetHeight };
+		const bool cacheLists = device.Options.CacheDrawLists;
+		if (!cacheLists) device.ListCache.Reset();
 
-		void SetClipRect(const ClipRect& rect)
+		for (int n = 0; n < drawData->CmdListsCount && !areas.empty(); n++)
 		{
-			Clip = rect;
-			const SDL_Rect clip = { rect.X, rect.Y, rect.Width, rect.Height };
-			SDL_RenderSetClipRect(Renderer, &clip);
+			const ImDrawList* commandList = drawData->CmdLists[n];
+			if (!IsListVisible(commandList, areas))
+			{
+				stats.TrianglesSubmitted += commandList->IdxBuffer.Size / 3;
+				stats.TrianglesCulled += commandList->IdxBuffer.Size / 3;
+				continue;
+			}
+			if (cacheLists && RenderCachedList(device, commandList, areas, screen, renderTarget, rasterizeFrame)) continue;
+
+			RenderList(device, commandList, commandList->VtxBuffer.Data, areas, SDL_Point{ 0, 0 }, renderTarget, rasterizeFrame);
 		}
 
-		void EnableClip() { SetClipRect(Clip); }
-		void DisableClip() { SDL_RenderSetClipRect(Renderer, nullptr); }
+		device.FlushFrame();
+		device.DisableClip();
+
+		device.State.SetTarget(initialRenderTarget);
 
-		SDL_Texture* MakeTexture(int width, int height)
+		// The composite texture has to be copied every frame, the render target was most likely cleared since the previous one. With a render
+		// scale, this is the one copy that scales the whole UI up to the size of the render target.
+		if (device.CompositeTexture)
 		{
-			SDL_Texture* texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET, width, height);
-			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
-			return texture;
+			ScopedTimer timer(stats.CopyTime);
+			SDL_RenderCopy(device.Renderer, device.CompositeTexture, nullptr, nullptr);
+			stats.SDLCalls++;
 		}
 
-		void UseAsRenderTarget(SDL_Texture* texture)
+		// Restores the state of the renderer and trims the caches for the next frame.
 		{
-			SDL_SetRenderTarget(Renderer, texture);
-			if (texture)
+			ScopedTimer timer(stats.CleanupTime);
+
+			// The clip rect to restore was read without a scale.
+			if (isScaledBySDL)
 			{
-				SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 0);
-				SDL_RenderClear(Renderer);
+				SDL_RenderSetScale(device.Renderer, 1.0f, 1.0f);
+				device.State.Refresh();
 			}
+			device.State.End();
+
+			SDL_RenderSetScale(device.Renderer, initialScaleX, initialScaleY);
+
+			if (cacheLists) device.ListCache.EndFrame();
+
+			device.EstimateDegradedFrames();
+			device.TrimTriangleCache();
+			device.Textures.EndFrame();
+			device.CountCachedTextures();
 		}
-	};
 
-	struct Rect
+		// The traversal is everything that isn't part of one of the other phases.
+		stats.TotalTime = static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+		stats.TraversalTime = std::max(stats.TotalTime - stats.RasterizationTime - stats.CopyTime - stats.CleanupTime, 0.0);
+		device.RecordHistory();
+
+		return changed;
+	}
+
+	bool Render(ImDrawData* drawData)
+	{
+		return Render(DefaultContext, drawData);
+	}
+
+	void Submit(Context* context, ImDrawData* drawData)
+	{
+		Device& device = *context;
+		AsyncRenderer::Frame& frame = device.Async.BeginSubmit();
+
+		// Nothing here may use the renderer, so the frame is sized after the display instead of the render target.
+		const float renderScale = device.Options.RenderScale > 0.0f ? device.Options.RenderScale : 1.0f;
+		const ImVec2 scale(
+			(drawData->FramebufferScale.x > 0.0f ? drawData->FramebufferScale.x : 1.0f) * renderScale,
+			(drawData->FramebufferScale.y > 0.0f ? drawData->FramebufferScale.y : 1.0f) * renderScale);
+		frame.Width = std::max(static_cast<int>(std::ceil(drawData->DisplaySize.x * scale.x)), 1);
+		frame.Height = std::max(static_cast<int>(std::ceil(drawData->DisplaySize.y * scale.y)), 1);
+
+		while (frame.Lists.size() < static_cast<size_t>(drawData->CmdListsCount)) frame.Lists.push_back(std::make_unique<ImDrawList>(nullptr));
+		for (int n = 0; n < drawData->CmdListsCount; n++) CopyDrawList(*drawData->CmdLists[n], *frame.Lists[n], drawData->DisplayPos, scale);
+		frame.ListCount = drawData->CmdListsCount;
+
+		frame.FontPixels = &device.FontPixels;
+		frame.WhitePixel = device.WhitePixel;
+		frame.ThreadCount = std::max(device.Options.RasterizerThreads > 0 ? device.Options.RasterizerThreads : SDL_GetCPUCount(), 1);
+
+		device.Async.EndSubmit();
+	}
+
+	void Submit(ImDrawData* drawData)
 	{
-		float MinX, MinY, MaxX, MaxY;
-		float MinU, MinV, MaxU, MaxV;
+		Submit(DefaultContext, drawData);
+	}
+
+	bool Composite(Context* context)
+	{
+		Device& device = *context;
+		const Uint64 start = SDL_GetPerformanceCounter();
+		AsyncRenderer::Frame* frame = device.Async.BeginComposite(device.Options.SubmitLatency);
+		if (!frame) return false;
+
+		if (device.CacheWasInvalidated) {
+			device.CacheWasInvalidated = false;
+			device.ResetTriangleCache();
+			device.Damage.Invalidate();
+			device.ListCache.Reset();
+		}
+
+		device.Stats = Stats();
+		Stats& stats = device.Stats;
+		stats.TrianglesSubmitted = frame->TrianglesSubmitted;
+		stats.PixelsRasterized = frame->PixelsRasterized;
+
+		float initialScaleX, initialScaleY;
+		SDL_RenderGetScale(device.Renderer, &initialScaleX, &initialScaleY);
+		SDL_RenderSetScale(device.Renderer, 1.0f, 1.0f);
 
-		bool IsOnExtreme(const ImVec2& point) const
+		device.State.Begin();
+		SDL_Texture* initialRenderTarget = device.State.GetTarget();
+
+		// With a render scale, the frame is drawn into the composite texture, which is then stretched onto the render target like in Render.
+		SDL_Texture* renderTarget = initialRenderTarget;
+		const bool isScaled = device.Options.RenderScale > 0.0f && device.Options.RenderScale != 1.0f;
+		if (isScaled)
+		{
+			device.PrepareComposite(frame->Width, frame->Height);
+			device.Damage.Invalidate();
+			renderTarget = device.CompositeTexture;
+			device.State.SetTarget(renderTarget);
+			device.ClearAreas({ SDL_Rect{ 0, 0, frame->Width, frame->Height } });
+		}
+		else if (device.CompositeTexture)
 		{
-			return (point.x == MinX || point.x == MaxX) && (point.y == MinY || point.y == MaxY);
+			device.ReleaseComposite();
 		}
 
-		bool UsesOnlyColor() const
+		device.SetClipRect(Device::ClipRect{ 0, 0, frame->Width, frame->Height });
+		for (const AsyncRenderer::Step& step : frame->Steps)
 		{
-			const ImVec2& whitePixel = ImGui::GetIO().Fonts->TexUvWhitePixel;
+			if (step.Layer >= 0)
+			{
+				device.CopyFrame(*frame->Layers[step.Layer], frame->LayerAreas[step.Layer]);
+				continue;
+			}
 
-			return MinU == MaxU && MinU == whitePixel.x && MinV == MaxV && MaxV == whitePixel.y;
+			// Commands with your own textures or callbacks are drawn by SDL as usual, without counting their triangles again.
+			const size_t submitted = stats.TrianglesSubmitted;
+			const Device::ClipRect clipRect = { step.Clip.x, step.Clip.y, step.Clip.w, step.Clip.h };
+			RenderCommand(device, step.List, step.Command, step.List->VtxBuffer.Data, step.Indices, clipRect, renderTarget, false);
+			stats.TrianglesSubmitted = submitted;
 		}
 
-		static Rect CalculateBoundingBox(const ImDrawVert& v0, const ImDrawVert& v1, const ImDrawVert& v2)
+		device.DisableClip();
+		device.State.SetTarget(initialRenderTarget);
+
+		if (isScaled)
 		{
-			return Rect{
-				std::min({ v0.pos.x, v1.pos.x, v2.pos.x }),
-				std::min({ v0.pos.y, v1.pos.y, v2.pos.y }),
-				std::max({ v0.pos.x, v1.pos.x, v2.pos.x }),
-				std::max({ v0.pos.y, v1.pos.y, v2.pos.y }),
-				std::min({ v0.uv.x, v1.uv.x, v2.uv.x }),
-				std::min({ v0.uv.y, v1.uv.y, v2.uv.y }),
-				std::max({ v0.uv.x, v1.uv.x, v2.uv.x }),
-				std::max({ v0.uv.y, v1.uv.y, v2.uv.y })
-			};
+			ScopedTimer timer(stats.CopyTime);
+			SDL_RenderCopy(device.Renderer, device.CompositeTexture, nullptr, nullptr);
+			stats.SDLCalls++;
 		}
-	};
 
-	void DrawTriangle(ImDrawVert v1, ImDrawVert v2, ImDrawVert v3, SDL_Texture *texture)
-	{
-		// This function operates in s28.4 fixed point: it's more precise than
-		// floating point and often faster. This also effectively lets us work in
-		// a subpixel space where each pixel is divided into 256 subpixels.
-		// TODO: check for overflow
-
-		// Find integral bounding box, scale to fixed point. We use this to
-		// iterate over all pixels possibly covered by the triangle.
-		const Sint32 minXf = SDL_floor(SDL_min(v1.pos.x, SDL_min(v2.pos.x, v3.pos.x))) * 16;
-		const Sint32 minYf = SDL_floor(SDL_min(v1.pos.y, SDL_min(v2.pos.y, v3.pos.y))) * 16;
-		const Sint32 maxXf = SDL_ceil(SDL_max(v1.pos.x, SDL_max(v2.pos.x, v3.pos.x))) * 16;
-		const Sint32 maxYf = SDL_ceil(SDL_max(v1.pos.y, SDL_max(v2.pos.y, v3.pos.y))) * 16;
-
-		// Find center of bounding box, used for translating coordinates.
-		// This accomplishes two things: 1) makes the fixed point calculations less
-		// likely to overflow 2) makes it less likely that triangles will be rendered
-		// differently on different parts of the screen (seems to happen sometimes
-		// with fractional coordinates). Make sure they're on integer boundaries too,
-		// to make it easy to calculate our starting position.
-		const Sint32 meanXf = round((maxXf - minXf) / 2 / 16) * 16;
-		const Sint32 meanYf = round((maxYf - minYf) / 2 / 16) * 16;
-
-		// Translate vertex coordinates with respect to the center of the bounding
-		// box, and scale to fixed point.
-		Sint32 f1x = round(v1.pos.x * 16) - meanXf;
-		Sint32 f1y = round(v1.pos.y * 16) - meanYf;
-		Sint32 f2x = round(v2.pos.x * 16) - meanXf;
-		Sint32 f2y = round(v2.pos.y * 16) - meanYf;
-		Sint32 f3x = round(v3.pos.x * 16) - meanXf;
-		Sint32 f3y = round(v3.pos.y * 16) - meanYf;
-
-		// Calculate starting position for iteration. It's the top-left of our
-		// bounding box with respect to the center of the bounding box. We add a
-		// half-pixel on each axis to match hardware renderers, which evaluate at the
-		// center of pixels.
-		const Sint32 px = minXf - meanXf + 8;
-		const Sint32 py = minYf - meanYf + 8;
-
-		// Calculate barycentric coordinates at starting position. Barycentric
-		// coordinates tell us the position of a point with respect to the
-		// edges/vertices of a triangle: we can easily use these to calculate if
-		// a point is inside a triangle (the three barycentric coordinates will all
-		// be positive) and how to interpolate vertex attributes (multiply them by
-		// the normalized barycentric coordinates at that point.)
-		Sint32 w1 = (f3x - f2x) * (py - f2y) - (f3y - f2y) * (px - f2x);
-		Sint32 w2 = (f1x - f3x) * (py - f3y) - (f1y - f3y) * (px - f3x);
-		Sint32 w3 = (f2x - f1x) * (py - f1y) - (f2y - f1y) * (px - f1x);
-
-		// Calculate the normalization factor for transforming our barycentric
-		// coordinates into interpolation constants. If it's negative, then the
-		// triangle is back-facing (wound the wrong way), and we flip two vertices
-		// to make it front-facing. Keep this factor as a float since 1) we'll be
-		// dividing by it later 2) we don't lose precision going through the raster
-		// loop.
-		float normalization = (w1 + w2 + w3);
-		if (normalization < 0) {
-			ImDrawVert vswap = v3;
-			v3 = v2;
-			v2 = vswap;
-
-			Sint32 fxswap = f3x;
-			f3x = f2x;
-			f2x = fxswap;
-			Sint32 fyswap = f3y;
-			f3y = f2y;
-			f2y = fyswap;
-
-			Sint32 wswap = w3;
-			w3 = -w2;
-			w2 = -wswap;
-			w1 = -w1;
-
-			normalization = -normalization;
-		}
-
-		// We deal with shared edges between triangles by defining a fill rule: only
-		// edges on the top or left of the triangle will be filled. We could change
-		// the comparison in the loop below to differentiate between greater-than
-		// and greater-or-equal-than, but since we're in fixed point space where
-		// everything is an integer we instead add a bias to each barycentric
-		// coordinate corresponding to a non-top, non-left edge.
-		const int bias1 = ((f3y == f2y && f3x > f2x) || f3x < f2x) ? 0 : -1;
-		const int bias2 = ((f3y == f1y && f1x > f3x) || f1x < f3x) ? 0 : -1;
-		const int bias3 = ((f2y == f1y && f2x > f1x) || f2x < f1x) ? 0 : -1;
-		w1 += bias1;
-		w2 += bias2;
-		w3 += bias3;
-
-		// As we go through each pixel, we use the barycentric coordinates to check
-		// if they're covered by the triangle. We could recalculate them every time,
-		// but since they're linear we can calculate the linear factors with respect
-		// to advancing through columns and rows and just add each time through the
-		// loop. We multiply to get from subpixel space back to pixel space, since
-		// we'll be iterating pixel by pixel.
-		const Sint32 a1 = (f2y - f3y) * 16;
-		const Sint32 a2 = (f3y - f1y) * 16;
-		const Sint32 a3 = (f1y - f2y) * 16;
-		const Sint32 b1 = (f3x - f2x) * 16;
-		const Sint32 b2 = (f1x - f3x) * 16;
-		const Sint32 b3 = (f2x - f1x) * 16;
-
-		// Save the original texture color and alpha mod here, since we change it
-		// according to vertex attributes and need to return it to its original state
-		// afterwards.
-		Uint8 original_mod_r, original_mod_g, original_mod_b, original_mod_a;
-		if (texture) {
-			SDL_GetTextureColorMod(texture, &original_mod_r, &original_mod_g, &original_mod_b);
-			SDL_GetTextureAlphaMod(texture, &original_mod_a);
-		}
-
-		// Store texture width and height for use in mapping vertex attributes
-		int texture_width = 0, texture_height = 0;
-		if (texture) {
-			SDL_QueryTexture(texture, NULL, NULL, &texture_width, &texture_height);
-		}
-
-		// Precalculate normalized vertex attributes. We just need to multiply these
-		// by the barycentric coordinates and sum them to get the interpolated vertex
-		// attribute for any point. This can save a few frames per second.
-		const float col1r = Color(v1.col).R * 255 / normalization;
-		const float col1g = Color(v1.col).G * 255 / normalization;
-		const float col1b = Color(v1.col).B * 255 / normalization;
-		const float col1a = Color(v1.col).A * 255 / normalization;
-		const float col2r = Color(v2.col).R * 255 / normalization;
-		const float col2g = Color(v2.col).G * 255 / normalization;
-		const float col2b = Color(v2.col).B * 255 / normalization;
-		const float col2a = Color(v2.col).A * 255 / normalization;
-		const float col3r = Color(v3.col).R * 255 / normalization;
-		const float col3g = Color(v3.col).G * 255 / normalization;
-		const float col3b = Color(v3.col).B * 255 / normalization;
-		const float col3a = Color(v3.col).A * 255 / normalization;
-		const float v1u = v1.uv.x * texture_width / normalization;
-		const float v1v = v1.uv.y * texture_height / normalization;
-		const float v2u = v2.uv.x * texture_width / normalization;
-		const float v2v = v2.uv.y * texture_height / normalization;
-		const float v3u = v3.uv.x * texture_width / normalization;
-		const float v3v = v3.uv.y * texture_height / normalization;
-
-		// If the triangle is uniformly-colored, we can get a big speed up by setting
-		// the color once and drawing batches of rows, rather than drawing individually
-		// colored pixels. Avoid malloc and a dynamic buffer size since it's slower
-		// than just grabbing space from the stack.
-		bool isUniformColor = false;
-		SDL_Rect rectsbuffer[1024];
-		int rects_i = 0;
-		if (!texture && v1.col == v2.col && v1.col == v3.col) {
-			isUniformColor = true;
-			SDL_SetRenderDrawColor(CurrentDevice->Renderer,
-				Color(v1.col).R * 255,
-				Color(v1.col).G * 255,
-				Color(v1.col).B * 255,
-				Color(v1.col).A * 255
-			);
-		}
-
-		// Iterate over all pixels in the bounding box.
-		for (int y = minYf / 16; y <= maxYf / 16; y++) {
-			// Stash barycentric coordinates at start of row
-			Sint32 w1_row = w1;
-			Sint32 w2_row = w2;
-			Sint32 w3_row = w3;
-
-			// Keep track of where the triangle starts on this row, as an optimization
-			// to draw uniformly-colored triangles.
-			bool in_triangle = false;
-			int x_start;
-
-			for (int x = minXf / 16; x <= maxXf / 16; x++) {
-				// If all barycentric coordinates are positive, we're inside the triangle
-				if (w1 >= 0 && w2 >= 0 && w3 >= 0) {
-					if (!in_triangle) {
-						// We draw uniformly-colored triangles row by row, so we need to keep
-						// track of where the row starts and know when it ends.
-						x_start = x;
-						in_triangle = true;
-					}
+		{
+			ScopedTimer timer(stats.CleanupTime);
 
-					if (!isUniformColor) {
-						// Fix the adjustment due to fill rule. It's incorrect when calculating
-						// interpolation values.
-						const Sint32 alpha = w1 - bias1;
-						const Sint32 beta = w2 - bias2;
-						const Sint32 gamma = w3 - bias3;
-
-						// Interpolate color
-						const Uint8 r = col1r * alpha + col2r * beta + col3r * gamma;
-						const Uint8 g = col1g * alpha + col2g * beta + col3g * gamma;
-						const Uint8 b = col1b * alpha + col2b * beta + col3b * gamma;
-						const Uint8 a = col1a * alpha + col2a * beta + col3a * gamma;
-
-						if (!texture) {
-							// Draw a single colored pixel
-							SDL_SetRenderDrawColor(CurrentDevice->Renderer, r, g, b, a);
-							SDL_RenderDrawPoint(CurrentDevice->Renderer, x, y);
-						} else {
-							// Copy a pixel from the source texture to the target pixel. This
-							// effectively does nearest neighbor sampling. Could probably be
-							// extended to copy from a larger rect to do bilinear sampling if
-							// needed.
-							const int u = v1u * alpha + v2u * beta + v3u * gamma;
-							const int v = v1v * alpha + v2v * beta + v3v * gamma;
-							SDL_SetTextureColorMod(texture, r, g, b);
-							SDL_SetTextureAlphaMod(texture, a);
-							SDL_Rect srcrect;
-							srcrect.x = u;
-							srcrect.y = v;
-							srcrect.w = 1;
-							srcrect.h = 1;
-							SDL_Rect destrect;
-							destrect.x = x;
-							destrect.y = y;
-							destrect.w = 1;
-							destrect.h = 1;
-							SDL_RenderCopy(CurrentDevice->Renderer, texture, &srcrect, &destrect);
-						}
-					}
-				} else if (in_triangle) {
-					// No longer in triangle, so we're done with this row.
-					if (isUniformColor) {
-						// For uniformly-colored triangles, store lines so we can send them
-						// to the renderer in batches. This provides a huge speedup in most
-						// cases (even with SDL 2.0.10's built-in batching!).
-						rectsbuffer[rects_i].x = x_start;
-						rectsbuffer[rects_i].y = y;
-						rectsbuffer[rects_i].w = x - x_start;
-						rectsbuffer[rects_i].h = 1;
-						rects_i++;
-						if (rects_i == 1024) {
-							SDL_RenderFillRects(CurrentDevice->Renderer, rectsbuffer, rects_i);
-							rects_i = 0;
-						}
-					}
+			device.State.End();
 
-					break;
-				}
+			SDL_RenderSetScale(device.Renderer, initialScaleX, initialScaleY);
 
-				// Increment barycentric coordinates one pixel rightwards
-				w1 += a1;
-				w2 += a2;
-				w3 += a3;
-			}
-			// Increment barycentric coordinates one pixel downwards
-			w1 = w1_row + b1;
-			w2 = w2_row + b2;
-			w3 = w3_row + b3;
+			device.TrimTriangleCache();
+			device.Textures.EndFrame();
+			device.CountCachedTextures();
 		}
 
-		if (isUniformColor) {
-			SDL_RenderFillRects(CurrentDevice->Renderer, rectsbuffer, rects_i);
-		}
+		// The rasterization happened on the worker, and only counts towards the total time as far as this had to wait for it.
+		stats.RasterizationTime = frame->RasterizationTime;
+		stats.TotalTime = static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+		stats.TraversalTime = std::max(stats.TotalTime - stats.CopyTime - stats.CleanupTime, 0.0);
+		device.RecordHistory();
 
-		// Restore original texture color and alpha mod.
-		if (texture) {
-			SDL_SetTextureColorMod(texture, original_mod_r, original_mod_g, original_mod_b);
-			SDL_SetTextureAlphaMod(texture, original_mod_a);
-		}
+		device.Async.EndComposite();
+		return true;
 	}
-}
 
-namespace ImGuiSDL
-{
-	static int ImGuiSDLEventWatch(void *userdata, SDL_Event *event) {
-		if (event->type == SDL_RENDER_TARGETS_RESET) {
-			CurrentDevice->CacheWasInvalidated = true;
+	bool Composite()
+	{
+		return Composite(DefaultContext);
+	}
+
+	struct Capture
+	{
+		MappedFile File;
+		SDL_Texture* FontTexture = nullptr;
+		const unsigned char* FontPixels = nullptr;
+		int FontWidth = 0, FontHeight = 0;
+		ImVec2 WhitePixel;
+
+		// The vertex and index buffers of the draw lists point into the mapped file, they have to be taken away again before the draw lists
+		// are destroyed, so that ImGui doesn't try to free them.
+		std::vector<std::unique_ptr<ImDrawList>> Lists;
+		std::vector<ImDrawList*> ListPointers;
+		ImDrawData DrawData;
+
+		~Capture()
+		{
+			for (const auto& list : Lists)
+			{
+				list->VtxBuffer.Data = nullptr;
+				list->VtxBuffer.Size = list->VtxBuffer.Capacity = 0;
+				list->IdxBuffer.Data = nullptr;
+				list->IdxBuffer.Size = list->IdxBuffer.Capacity = 0;
+			}
+			if (FontTexture) SDL_DestroyTexture(FontTexture);
 		}
-		return 0;
+	};
+
+	static void AppendBytes(std::vector<unsigned char>& buffer, const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		buffer.insert(buffer.end(), bytes, bytes + size);
+		buffer.resize((buffer.size() + 7) & ~size_t(7), 0);
 	}
 
-	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight)
+	bool SaveCapture(Context* context, const ImDrawData* drawData, const char* path)
 	{
-		ImGuiIO& io = ImGui::GetIO();
-		io.DisplaySize.x = static_cast<float>(windowWidth);
-		io.DisplaySize.y = static_cast<float>(windowHeight);
+		std::vector<unsigned char> buffer;
 
-		ImGui::GetStyle().WindowRounding = 0.0f;
-		ImGui::GetStyle().AntiAliasedFill = false;
-		ImGui::GetStyle().AntiAliasedLines = false;
-		ImGui::GetStyle().ChildRounding = 0.0f;
-		ImGui::GetStyle().PopupRounding = 0.0f;
-		ImGui::GetStyle().FrameRounding = 0.0f;
-		ImGui::GetStyle().ScrollbarRounding = 0.0f;
-		ImGui::GetStyle().GrabRounding = 0.0f;
-		ImGui::GetStyle().TabRounding = 0.0f;
+		CaptureHeader header = {};
+		std::memcpy(header.Magic, CaptureMagic, sizeof(header.Magic));
+		header.Version = CaptureVersion;
+		header.VertexSize = sizeof(ImDrawVert);
+		header.IndexSize = sizeof(ImDrawIdx);
+		header.ListCount = static_cast<Uint32>(drawData->CmdListsCount);
+		header.DisplayPos[0] = drawData->DisplayPos.x;
+		header.DisplayPos[1] = drawData->DisplayPos.y;
+		header.DisplaySize[0] = drawData->DisplaySize.x;
+		header.DisplaySize[1] = drawData->DisplaySize.y;
+		header.FramebufferScale[0] = drawData->FramebufferScale.x;
+		header.FramebufferScale[1] = drawData->FramebufferScale.y;
+		header.FontWidth = static_cast<Uint32>(context->FontPixels.Width);
+		header.FontHeight = static_cast<Uint32>(context->FontPixels.Height);
+		header.WhitePixel[0] = context->WhitePixel.x;
+		header.WhitePixel[1] = context->WhitePixel.y;
+		AppendBytes(buffer, &header, sizeof(header));
 
-		// Loads the font texture.
-		unsigned char* pixels;
-		int width, height;
-		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
-		static constexpr uint32_t rmask = 0x000000ff, gmask = 0x0000ff00, bmask = 0x00ff0000, amask = 0xff000000;
-		SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(pixels, width, height, 32, 4 * width, rmask, gmask, bmask, amask);
-		io.Fonts->TexID = SDL_CreateTextureFromSurface(renderer, surface);
-		SDL_FreeSurface(surface);
+		// The font pixels are packed the same way ImGui hands them out, so they can be stored as they are.
+		AppendBytes(buffer, context->FontPixels.Pixels.data(), context->FontPixels.Pixels.size() * sizeof(ImU32));
+
+		std::vector<SDL_Texture*> textures;
+		std::vector<CaptureCommand> commands;
+		for (int n = 0; n < drawData->CmdListsCount; n++)
+		{
+			const ImDrawList* list = drawData->CmdLists[n];
+
+			// Callbacks can't be stored, ImGui doesn't give them any elements so they can be left out without moving the other commands' indices.
+			commands.clear();
+			for (const ImDrawCmd& command : list->CmdBuffer)
+			{
+				if (command.UserCallback) continue;
+
+				CaptureCommand captured = { { command.ClipRect.x, command.ClipRect.y, command.ClipRect.z, command.ClipRect.w }, 0, command.ElemCount };
+				SDL_Texture* texture = static_cast<SDL_Texture*>(command.TextureId);
+				if (IsFontTexture(command.TextureId)) captured.Texture = FontTextureHandle;
+				else if (texture)
+				{
+					const auto location = std::find(textures.begin(), textures.end(), texture);
+					captured.Texture = FontTextureHandle + 1 + static_cast<Uint32>(location - textures.begin());
+					if (location == textures.end()) textures.push_back(texture);
+				}
+				commands.push_back(captured);
+			}
+
+			const CaptureList captured = { static_cast<Uint32>(list->VtxBuffer.Size), static_cast<Uint32>(list->IdxBuffer.Size), static_cast<Uint32>(commands.size()), 0 };
+			AppendBytes(buffer, &captured, sizeof(captured));
+			AppendBytes(buffer, commands.data(), commands.size() * sizeof(CaptureCommand));
+			AppendBytes(buffer, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+			AppendBytes(buffer, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+		}
 
-		CurrentDevice = new Device(renderer);
-		SDL_AddEventWatch(ImGuiSDLEventWatch, nullptr);
+		SDL_RWops* file = SDL_RWFromFile(path, "wb");
+		if (!file) return false;
+		const bool written = SDL_RWwrite(file, buffer.data(), 1, buffer.size()) == buffer.size();
+		return SDL_RWclose(file) == 0 && written;
 	}
 
-	void Deinitialize()
+	bool SaveCapture(const ImDrawData* drawData, const char* path)
 	{
-		// Frees up the memory of the font texture.
-		ImGuiIO& io = ImGui::GetIO();
-		SDL_Texture* texture = static_cast<SDL_Texture*>(io.Fonts->TexID);
-		SDL_DestroyTexture(texture);
+		return SaveCapture(DefaultContext, drawData, path);
+	}
 
-		delete CurrentDevice;
-		SDL_DelEventWatch(ImGuiSDLEventWatch, nullptr);
+	// Reads the next part of a capture file, or returns null if the file ends too early.
+	static const unsigned char* ReadBytes(const MappedFile& file, size_t& offset, size_t size)
+	{
+		if (size > file.GetSize() || offset > file.GetSize() - size) return nullptr;
+
+		const unsigned char* data = file.GetData() + offset;
+		offset = (offset + size + 7) & ~size_t(7);
+		return data;
 	}
 
-	void Render(ImDrawData* drawData)
+	// Checks that the commands of a captured list don't use more indices than it has, and that every index refers to one of its vertices, so that
+	// a corrupt or edited capture can't make Render read outside of its buffers.
+	static bool IsCaptureListValid(const CaptureList& list, const unsigned char* commands, const unsigned char* indices)
 	{
-		if (CurrentDevice->CacheWasInvalidated) {
-			CurrentDevice->CacheWasInvalidated = false;
-			CurrentDevice->TriangleCache.Reset();
-		}
+		if (list.VertexCount > static_cast<Uint32>(INT_MAX) || list.IndexCount > static_cast<Uint32>(INT_MAX)) return false;
 
-		size_t num_triangles = 0;
+		Uint64 elements = 0;
+		for (Uint32 i = 0; i < list.CommandCount; i++)
+		{
+			CaptureCommand stored;
+			std::memcpy(&stored, commands + i * sizeof(CaptureCommand), sizeof(stored));
+			elements += stored.ElemCount;
+		}
+		if (elements > list.IndexCount) return false;
 
-		float initialScaleX, initialScaleY;
-		SDL_RenderGetScale(CurrentDevice->Renderer, &initialScaleX, &initialScaleY);
-		SDL_RenderSetScale(CurrentDevice->Renderer, 1.0f, 1.0f);
+		for (Uint32 i = 0; i < list.IndexCount; i++)
+		{
+			ImDrawIdx index;
+			std::memcpy(&index, indices + i * sizeof(ImDrawIdx), sizeof(index));
+			if (index >= list.VertexCount) return false;
+		}
+		return true;
+	}
 
-		SDL_BlendMode blendMode;
-		SDL_GetRenderDrawBlendMode(CurrentDevice->Renderer, &blendMode);
-		SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, SDL_BLENDMODE_BLEND);
+	Capture* LoadCapture(SDL_Renderer* renderer, const char* path)
+	{
+		auto capture = std::make_unique<Capture>();
+		if (!capture->File.Open(path)) return nullptr;
 
-		Uint8 initialR, initialG, initialB, initialA;
-		SDL_GetRenderDrawColor(CurrentDevice->Renderer, &initialR, &initialG, &initialB, &initialA);
+		size_t offset = 0;
+		CaptureHeader header;
+		const unsigned char* headerBytes = ReadBytes(capture->File, offset, sizeof(CaptureHeader));
+		if (!headerBytes) return nullptr;
+		std::memcpy(&header, headerBytes, sizeof(header));
 
-		SDL_bool initialClipEnabled = SDL_RenderIsClipEnabled(CurrentDevice->Renderer);
-		SDL_Rect initialClipRect;
-		SDL_RenderGetClipRect(CurrentDevice->Renderer, &initialClipRect);
+		if (std::memcmp(header.Magic, CaptureMagic, sizeof(header.Magic)) != 0 || header.Version != CaptureVersion) return nullptr;
+		if (header.VertexSize != sizeof(ImDrawVert) || header.IndexSize != sizeof(ImDrawIdx)) return nullptr;
 
-		SDL_Texture* initialRenderTarget = SDL_GetRenderTarget(CurrentDevice->Renderer);
+		capture->FontWidth = static_cast<int>(header.FontWidth);
+		capture->FontHeight = static_cast<int>(header.FontHeight);
+		capture->WhitePixel = ImVec2(header.WhitePixel[0], header.WhitePixel[1]);
+		capture->FontPixels = ReadBytes(capture->File, offset, static_cast<size_t>(header.FontWidth) * header.FontHeight * sizeof(ImU32));
+		if (!capture->FontPixels) return nullptr;
 
-		ImGuiIO& io = ImGui::GetIO();
+		capture->FontTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STATIC, capture->FontWidth, capture->FontHeight);
+		if (!capture->FontTexture) return nullptr;
+		SDL_UpdateTexture(capture->FontTexture, nullptr, capture->FontPixels, capture->FontWidth * static_cast<int>(sizeof(ImU32)));
+		SDL_SetTextureBlendMode(capture->FontTexture, SDL_BLENDMODE_BLEND);
 
-		for (int n = 0; n < drawData->CmdListsCount; n++)
+		int totalVertices = 0, totalIndices = 0;
+		for (Uint32 n = 0; n < header.ListCount; n++)
 		{
-			auto commandList = drawData->CmdLists[n];
-			auto vertexBuffer = commandList->VtxBuffer;
-			auto indexBuffer = commandList->IdxBuffer.Data;
+			CaptureList captured;
+			const unsigned char* listBytes = ReadBytes(capture->File, offset, sizeof(CaptureList));
+			if (!listBytes) return nullptr;
+			std::memcpy(&captured, listBytes, sizeof(captured));
 
-			for (int cmd_i = 0; cmd_i < commandList->CmdBuffer.Size; cmd_i++)
-			{
-				const ImDrawCmd* drawCommand = &commandList->CmdBuffer[cmd_i];
+			const unsigned char* commands = ReadBytes(capture->File, offset, static_cast<size_t>(captured.CommandCount) * sizeof(CaptureCommand));
+			const unsigned char* vertices = ReadBytes(capture->File, offset, static_cast<size_t>(captured.VertexCount) * sizeof(ImDrawVert));
+			const unsigned char* indices = ReadBytes(capture->File, offset, static_cast<size_t>(captured.IndexCount) * sizeof(ImDrawIdx));
+			if (!commands || !vertices || !indices) return nullptr;
+			if (!IsCaptureListValid(captured, commands, indices)) return nullptr;
 
-				const Device::ClipRect clipRect = {
-					static_cast<int>(drawCommand->ClipRect.x),
-					static_cast<int>(drawCommand->ClipRect.y),
-					static_cast<int>(drawCommand->ClipRect.z - drawCommand->ClipRect.x),
-					static_cast<int>(drawCommand->ClipRect.w - drawCommand->ClipRect.y)
-				};
-				CurrentDevice->SetClipRect(clipRect);
+			auto list = std::make_unique<ImDrawList>(nullptr);
+			for (Uint32 i = 0; i < captured.CommandCount; i++)
+			{
+				CaptureCommand stored;
+				std::memcpy(&stored, commands + i * sizeof(CaptureCommand), sizeof(stored));
 
-				if (drawCommand->UserCallback)
-				{
-					drawCommand->UserCallback(commandList, drawCommand);
-				}
-				else
-				{
-					// Loops over triangles.
-					for (unsigned int i = 0; i + 3 <= drawCommand->ElemCount; i += 3)
-					{
-						num_triangles++;
-						ImDrawVert v0 = vertexBuffer[indexBuffer[i + 0]];
-						ImDrawVert v1 = vertexBuffer[indexBuffer[i + 1]];
-						ImDrawVert v2 = vertexBuffer[indexBuffer[i + 2]];
-
-						const Rect bounding = Rect::CalculateBoundingBox(v0, v1, v2);
-						const bool isTriangleUniformColor = v0.col == v1.col && v1.col == v2.col;
-						const bool doesTriangleUseOnlyColor = bounding.UsesOnlyColor();
-
-						if ((bounding.MinX > clipRect.X + clipRect.Width || bounding.MaxX < clipRect.X)
-							&& (bounding.MinY > clipRect.Y + clipRect.Height || bounding.MaxY < clipRect.Y)
-						) {
-							// Not in clip rect, ignore
-							continue;
-						}
+				// Only the font texture is part of the capture, the other textures are drawn as if the commands were untextured.
+				ImDrawCmd command;
+				command.ClipRect = ImVec4(stored.ClipRect[0], stored.ClipRect[1], stored.ClipRect[2], stored.ClipRect[3]);
+				command.TextureId = stored.Texture == FontTextureHandle ? static_cast<ImTextureID>(&FontTextureSentinel) : nullptr;
+				command.ElemCount = stored.ElemCount;
+				command.UserCallback = nullptr;
+				list->CmdBuffer.push_back(command);
+			}
 
-						SDL_Texture *texture = doesTriangleUseOnlyColor ? nullptr : (SDL_Texture*)drawCommand->TextureId;
-
-						// First we check if there is a cached version of this triangle already waiting for us. If so, we can just do a super fast texture copy.
-						v0.pos.x -= (int)bounding.MinX; v0.pos.y -= (int)bounding.MinY;
-						v1.pos.x -= (int)bounding.MinX; v1.pos.y -= (int)bounding.MinY;
-						v2.pos.x -= (int)bounding.MinX; v2.pos.y -= (int)bounding.MinY;
-
-						const Device::GenericTriangleKey key = std::make_tuple(
-							std::make_tuple(v0.pos.x, v0.pos.y, v0.uv.x, v0.uv.y, v0.col),
-							std::make_tuple(v1.pos.x, v1.pos.y, v1.uv.x, v1.uv.y, v1.col),
-							std::make_tuple(v2.pos.x, v2.pos.y, v2.uv.x, v2.uv.y, v2.col),
-							texture
-						);
-
-						if (CurrentDevice->TriangleCache.Contains(key)) {
-							const auto& cached = CurrentDevice->TriangleCache.At(key);
-							const SDL_Rect destination = { (int)bounding.MinX, (int)bounding.MinY, (int)cached->Width, (int)cached->Height };
-							SDL_RenderCopy(CurrentDevice->Renderer, cached->Texture, nullptr, &destination);
-						} else {
-							auto cached = std::make_unique<Device::TriangleCacheItem>();
-							cached->Width = bounding.MaxX - bounding.MinX + 1;
-							cached->Height = bounding.MaxY - bounding.MinY + 1;
-							cached->Texture = CurrentDevice->MakeTexture(cached->Width, cached->Height);
-
-							CurrentDevice->UseAsRenderTarget(cached->Texture);
-							SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, SDL_BLENDMODE_NONE);
-							DrawTriangle(v0, v1, v2, texture);
-							CurrentDevice->UseAsRenderTarget(initialRenderTarget);
-							SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, SDL_BLENDMODE_BLEND);
-
-							const SDL_Rect destination = { (int)bounding.MinX, (int)bounding.MinY, (int)cached->Width, (int)cached->Height };
-							SDL_RenderCopy(CurrentDevice->Renderer, cached->Texture, nullptr, &destination);
-
-							CurrentDevice->TriangleCache.Insert(key, std::move(cached));
-						}
-					}
-				}
+			// The buffers are used right where they are in the mapped file, they're never written to.
+			list->VtxBuffer.Data = reinterpret_cast<ImDrawVert*>(const_cast<unsigned char*>(vertices));
+			list->VtxBuffer.Size = list->VtxBuffer.Capacity = static_cast<int>(captured.VertexCount);
+			list->IdxBuffer.Data = reinterpret_cast<ImDrawIdx*>(const_cast<unsigned char*>(indices));
+			list->IdxBuffer.Size = list->IdxBuffer.Capacity = static_cast<int>(captured.IndexCount);
+			totalVertices += list->VtxBuffer.Size;
+			totalIndices += list->IdxBuffer.Size;
 
-				indexBuffer += drawCommand->ElemCount;
-			}
+			capture->ListPointers.push_back(list.get());
+			capture->Lists.push_back(std::move(list));
 		}
 
-		CurrentDevice->DisableClip();
+		ImDrawData& drawData = capture->DrawData;
+		drawData.Valid = true;
+		drawData.CmdListsCount = static_cast<int>(capture->ListPointers.size());
+#if IMGUI_VERSION_NUM >= 18980
+		for (ImDrawList* list : capture->ListPointers) drawData.CmdLists.push_back(list);
+#else
+		drawData.CmdLists = capture->ListPointers.data();
+#endif
+		drawData.TotalVtxCount = totalVertices;
+		drawData.TotalIdxCount = totalIndices;
+		drawData.DisplayPos = ImVec2(header.DisplayPos[0], header.DisplayPos[1]);
+		drawData.DisplaySize = ImVec2(header.DisplaySize[0], header.DisplaySize[1]);
+		drawData.FramebufferScale = ImVec2(header.FramebufferScale[0], header.FramebufferScale[1]);
 
-		SDL_SetRenderTarget(CurrentDevice->Renderer, initialRenderTarget);
-
-		SDL_RenderSetClipRect(CurrentDevice->Renderer, initialClipEnabled ? &initialClipRect : nullptr);
+		return capture.release();
+	}
 
-		SDL_SetRenderDrawColor(CurrentDevice->Renderer,
-			initialR, initialG, initialB, initialA);
+	ImDrawData* GetCaptureDrawData(Capture* capture)
+	{
+		return &capture->DrawData;
+	}
 
-		SDL_SetRenderDrawBlendMode(CurrentDevice->Renderer, blendMode);
+	void FreeCapture(Capture* capture)
+	{
+		delete capture;
+	}
 
-		SDL_RenderSetScale(CurrentDevice->Renderer, initialScaleX, initialScaleY);
+	Context* CreateContext(SDL_Renderer* renderer, const Capture* capture)
+	{
+		return MakeContext(renderer, capture->FontTexture, false, capture->FontPixels, capture->FontWidth, capture->FontHeight, capture->WhitePixel);
+	}
 
-		CurrentDevice->TriangleCache.SetCapacity(num_triangles);
-		CurrentDevice->TriangleCache.Clean();
+	void Initialize(SDL_Renderer* renderer, const Capture* capture)
+	{
+		DestroyContext(DefaultContext);
+		DefaultContext = CreateContext(renderer, capture);
 	}
 }
+
+// benchmark.cpp times internals that aren't part of the header, like the triangle cache with its real key. Building this file with
+// IMGUI_SDL_BENCHMARK defined includes it here, after everything it needs, so that the benchmark doesn't need a header of its own.
+#ifdef IMGUI_SDL_BENCHMARK
+#include "benchmark.cpp"
+#endif
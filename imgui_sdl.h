@@ -1,17 +1,210 @@
 ﻿#pragma once
 
+#include <cstddef>
+
 struct ImDrawData;
 struct SDL_Renderer;
 
 namespace ImGuiSDL
 {
-	// Call this to initialize the SDL renderer device that is internally used by the renderer.
+	// Call this to initialize the SDL renderer device that is internally used by the renderer. Calling it again destroys the previous one first.
 	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight);
+
+	// Settings that change how the draw data is rendered, see below.
+	struct Options;
+
+	// Same as Initialize above, with the given options instead of the defaults, including SimplifyStyle.
+	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight, const Options& options);
 	// Call this before destroying your SDL renderer or ImGui to ensure that proper cleanup is done. This doesn't do anything critically important though,
 	// so if you're fine with small memory leaks at the end of your application, you can even omit this.
 	void Deinitialize();
 
+	// Draw data that was loaded from a capture file.
+	struct Capture;
+
+	// Initializes the renderer for replaying captures, without an ImGui context. The font texture of the capture is used, so the capture has to be
+	// kept around until Deinitialize is called, and only captures made with the same font can be rendered.
+	void Initialize(SDL_Renderer* renderer, const Capture* capture);
+
 	// Call this every frame after ImGui::Render with ImGui::GetDrawData(). This will use the SDL_Renderer provided to the interfrace with Initialize
-	// to draw the contents of the draw data to the screen.
-	void Render(ImDrawData* drawData);
+	// to draw the contents of the draw data to the screen. Returns false if the draw data looks the same as in the previous frame, which is only
+	// checked with the RedrawDamagedRegions option, so if nothing else changed either you can skip SDL_RenderPresent.
+	bool Render(ImDrawData* drawData);
+
+	// Everything that's needed to render with one SDL renderer: the caches, the font texture, the options and the stats. Initialize sets up a
+	// context that the functions without a context parameter use, but you can create as many contexts as you like, for example one for every
+	// window of ImGui's multi-viewport branch. Contexts don't share any state, so different contexts can render from different threads at the
+	// same time, as long as every renderer is only used from one thread.
+	struct Context;
+
+	// Creates a context with its own copy of the font texture of the current ImGui context. Sets io.Fonts->TexID to an ID that all contexts share
+	// and that every context draws with its own font texture, so contexts can be created and destroyed in any order. Doesn't change the ImGui
+	// style, unlike Initialize.
+	Context* CreateContext(SDL_Renderer* renderer);
+	// Creates a context for replaying captures, see Initialize(SDL_Renderer*, const Capture*).
+	Context* CreateContext(SDL_Renderer* renderer, const Capture* capture);
+	// Call this before destroying the renderer of the context.
+	void DestroyContext(Context* context);
+
+	// Same as Render above, with the renderer of the context.
+	bool Render(Context* context, ImDrawData* drawData);
+
+	// Splits Render in two, so that rasterizing the UI overlaps with the rest of your frame instead of holding up the render thread. Submit copies
+	// the draw data and returns right away, and a background thread rasterizes the copy on the CPU like RasterizeFrames does. Composite then only
+	// uploads the result and copies it onto the render target, with the draw commands that use your own textures or callbacks drawn by SDL in
+	// between. Submit doesn't call SDL, so it can be called from a different thread than Composite. Damage tracking and cached draw lists don't
+	// apply to submitted frames. Composite returns false if there's no frame to draw (yet), see SubmitLatency.
+	void Submit(ImDrawData* drawData);
+	void Submit(Context* context, ImDrawData* drawData);
+	bool Composite();
+	bool Composite(Context* context);
+
+	// Uploads a region of the ImGui font atlas again after glyphs were added to it, in pixels of the atlas, and drops only the cached triangles that
+	// sample the font. If the atlas changed its size (for example after it was rebuilt for a different DPI), the font texture is created again.
+	// With several contexts, every one of them has to be updated.
+	// Returns false for contexts that replay captures, which don't have an ImGui font, or if the new font texture couldn't be created.
+	bool UpdateFontTexture(int x, int y, int width, int height);
+	bool UpdateFontTexture(Context* context, int x, int y, int width, int height);
+
+	// Settings that change how the draw data is rendered. The defaults are picked to be the fastest for most use cases.
+	struct Options
+	{
+		// When built against and running with SDL 2.0.18 or newer, every draw command is submitted with a single SDL_RenderGeometry call.
+		// Turning this off forces the software rasterizer and its triangle cache, which is always used with older SDL versions.
+		bool UseRenderGeometry = true;
+
+		// Triangles that miss the triangle cache are rasterized into a CPU buffer and uploaded with a single SDL_UpdateTexture call, instead of
+		// being drawn pixel by pixel with SDL calls. This only applies to untextured triangles and triangles using the font texture, triangles
+		// using your own textures are always drawn through SDL.
+		bool RasterizeOnCPU = true;
+
+		// Rasterizes everything on the CPU instead, a whole frame at a time. Triangles are binned into screen tiles that are rasterized in parallel
+		// by a pool of threads, and the finished frame is blended onto the render target with a single texture upload and copy. Draw commands using
+		// your own textures or callbacks are drawn in between as usual. Takes precedence over UseRenderGeometry and the triangle cache, and is
+		// meant for machines without a hardware accelerated renderer but with many CPU cores.
+		bool RasterizeFrames = false;
+
+		// The number of threads that RasterizeFrames uses, including the one calling Render. Zero uses one thread per CPU core.
+		int RasterizerThreads = 0;
+
+		// The number of frames between Submit and the Composite call that draws the frame, either zero or one. With zero, Composite draws the most
+		// recently submitted frame and waits until it's rasterized. With one, it draws the frame submitted before that, which had a whole frame to
+		// be rasterized, so Composite only waits if the rasterization takes longer than that.
+		int SubmitLatency = 1;
+
+		// Draws into a texture that is kept between frames, which is then copied onto the render target. Every frame, the draw lists are compared
+		// with the previous frame and only the areas that changed are drawn again. Draw lists with callbacks are always drawn again, but changes to
+		// the contents of your own textures aren't noticed, so turn this off while those are animated.
+		bool RedrawDamagedRegions = false;
+
+		// Renders draw lists (usually one window each) into textures of their own once they stayed the same for two frames, and then draws them
+		// with a single copy for as long as they don't change. Moving a window doesn't count as a change. Draw lists with callbacks are never cached.
+		bool CacheDrawLists = false;
+
+		// The most memory in bytes that the textures of cached draw lists may use together. The least recently used ones are freed first.
+		std::size_t DrawListCacheSize = 64 * 1024 * 1024;
+
+		// Caches single colored triangles in white and tints them with the texture color and alpha mod when they're drawn, so the same shape in a
+		// different color (like a checkmark that's hovered) is found in the triangle cache. Triangle positions are also snapped to a grid of
+		// TriangleCacheSubpixels steps per pixel, so the same shape at a slightly different fractional position is found too.
+		bool NormalizeTriangleKeys = false;
+
+		// The number of steps per pixel that NormalizeTriangleKeys snaps positions to. The rasterizer works with 16 steps per pixel anyway, so
+		// smaller values trade a little precision for more cache hits.
+		int TriangleCacheSubpixels = 16;
+
+		// Renders the whole UI into a texture of this fraction of the render target's size, which is then stretched onto the render target with
+		// a single copy, so a scale of 0.5 rasterizes a quarter of the pixels. Values above one supersample the UI instead. Independent of this,
+		// the positions of the draw data are multiplied by its FramebufferScale, so the UI is drawn at the right size on HiDPI displays. Cached
+		// triangles are stored in pixels of whatever they're drawn into, so both scales are part of their keys.
+		float RenderScale = 1.0f;
+
+		// The most time in milliseconds per frame that may be spent rasterizing triangles that missed the triangle cache. Once it's used up, the
+		// following untextured misses are drawn straight onto the render target without the cache, and are cached in one of the next frames
+		// instead. They keep their colors: single colored ones are drawn a batch of rows at a time, gradients like antialiased fringes a pixel at a
+		// time. Textured misses are still cached right away. Opening a large window then takes a few frames that draw part of it without the cache
+		// instead of one long one. Zero doesn't limit the time.
+		double TriangleCacheFillTime = 0.0;
+
+		// Collects the rectangle fills and texture copies of every draw command, and draws the ones that don't overlap grouped by texture and
+		// color, so that text, icons and cached triangles take a few batches in SDL instead of one for every change of texture. Draws that
+		// overlap are still drawn in their original order. This doesn't apply to SDL_RenderGeometry, which draws a whole command at once anyway.
+		bool ReorderDraws = false;
+
+		// The most memory in bytes that the texels of cached triangles may use together. The least recently used ones are evicted at the end of
+		// every frame, and their textures are kept for another frame so that new triangles can reuse them.
+		std::size_t TriangleCacheSize = 16 * 1024 * 1024;
+
+		// Turns off rounding and antialiasing in the ImGui style, so that most of the UI is drawn with rectangles. The style is kept as it is by
+		// default: rounded rectangles are filled from corner sprites, and other convex shapes and antialiased lines take one cache item each
+		// instead of one per triangle. Only Initialize reads this.
+		bool SimplifyStyle = false;
+	};
+
+	// Changes the options used by the following calls to Render. Has to be called after Initialize.
+	void SetOptions(const Options& options);
+	const Options& GetOptions();
+	void SetOptions(Context* context, const Options& options);
+	const Options& GetOptions(Context* context);
+
+	// Counters and timings of the most recent call to Render, to measure how well the caches work and where the time goes.
+	struct Stats
+	{
+		// Triangles of all draw commands, and the ones that were skipped because they are outside of their clip rect.
+		std::size_t TrianglesSubmitted = 0;
+		std::size_t TrianglesCulled = 0;
+
+		// Lookups of the software rasterizer's triangle cache, and the triangles that were evicted to keep it within TriangleCacheSize.
+		std::size_t TriangleCacheHits = 0;
+		std::size_t TriangleCacheMisses = 0;
+		std::size_t TriangleCacheEvictions = 0;
+
+		// Cache misses that were drawn without the cache because TriangleCacheFillTime was used up, and an estimate of how many more frames it
+		// takes until those are cached as well.
+		std::size_t TrianglesDeferred = 0;
+		std::size_t DegradedFrames = 0;
+
+		// What the caches hold after the frame: cached triangles, and the textures of all caches (including the ones waiting to be reused) along
+		// with roughly how much memory they use.
+		std::size_t CachedTriangles = 0;
+		std::size_t CachedTextures = 0;
+		std::size_t CachedTextureBytes = 0;
+
+		// Pixels that were rasterized by the software rasterizer, and the draw, upload and render state calls that were made to SDL.
+		std::size_t PixelsRasterized = 0;
+		std::size_t SDLCalls = 0;
+		// Runs of fills and copies with the same texture and color that were handed to SDL one after another, which SDL can draw as one batch.
+		std::size_t DrawBatches = 0;
+
+		// Wall time in milliseconds. Rasterization covers cache misses and the frame rasterizer, copy covers handing the results and batches to
+		// SDL, and cleanup covers restoring the renderer state and trimming the caches. Traversal is everything else, mostly walking the draw data.
+		double TraversalTime = 0.0;
+		double RasterizationTime = 0.0;
+		double CopyTime = 0.0;
+		double CleanupTime = 0.0;
+		double TotalTime = 0.0;
+		// The part of the rasterization time that was spent filling the triangle cache, which is what TriangleCacheFillTime limits.
+		double CacheFillTime = 0.0;
+	};
+
+	const Stats& GetStats();
+	const Stats& GetStats(Context* context);
+
+	// Writes the draw data of a frame, along with the font texture, into a binary file that can be replayed with LoadCapture. Textures are stored as
+	// handles, but only the font texture's pixels are part of the capture. Callbacks are left out. Has to be called after Initialize, and returns
+	// false if the file couldn't be written.
+	bool SaveCapture(const ImDrawData* drawData, const char* path);
+	bool SaveCapture(Context* context, const ImDrawData* drawData, const char* path);
+
+	// Maps a capture file into memory and creates its font texture on the renderer. The draw data uses the vertices and indices right where they
+	// are in the file, and can be passed to Render as often as you like. Commands that used one of your own textures are drawn untextured.
+	// Returns null if the file can't be read, or was written by an ImGui with different vertex or index types.
+	Capture* LoadCapture(SDL_Renderer* renderer, const char* path);
+	ImDrawData* GetCaptureDrawData(Capture* capture);
+	void FreeCapture(Capture* capture);
+
+	// Shows the stats of the most recent frames in an ImGui window, with a history of the frame times and cache hit rates. Call it between
+	// ImGui::NewFrame and ImGui::Render, like any other window.
+	void ShowStatsWindow(bool* open = nullptr);
+	void ShowStatsWindow(Context* context, bool* open = nullptr);
 }